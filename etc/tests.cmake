@@ -23,6 +23,15 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_chunked)
+ttest(byte_stream_peek_all)
+ttest(byte_stream_peek_slice)
+ttest(byte_stream_reserve)
+ttest(byte_stream_spsc)
+ttest(byte_stream_await)
+ttest(byte_stream_fd)
+ttest(byte_stream_mapped)
+ttest(byte_stream_large)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,12 +40,18 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_bitmap)
+ttest(reassembler_buffer)
+ttest(reassembler_pool)
+ttest(reassembler_batch)
+ttest(reassembler_sack)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
 ttest(wrapping_integers_unwrap)
 ttest(wrapping_integers_roundtrip)
 ttest(wrapping_integers_extra)
+ttest(wrapping_integers_batch)
 
 ttest(recv_connect)
 ttest(recv_transmit)
@@ -45,6 +60,8 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_timestamps)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +70,10 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_hold)
+ttest(send_congestion)
+ttest(send_rtt)
+ttest(send_fast_retransmit)
 
 ttest(net_interface)
 
@@ -76,6 +97,17 @@ add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (speed COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 12 -R '_speed_test')
 
+# benchmark matrices, written as JSON to the build directory for tracking across releases
+add_custom_target (bench
+  COMMAND byte_stream_benchmark "${PROJECT_BINARY_DIR}/byte_stream_benchmark.json"
+  COMMAND reassembler_benchmark "${PROJECT_BINARY_DIR}/reassembler_benchmark.json"
+  COMMAND wrapping_integers_benchmark "${PROJECT_BINARY_DIR}/wrapping_integers_benchmark.json"
+  COMMAND tcp_sender_benchmark "${PROJECT_BINARY_DIR}/tcp_sender_benchmark.json"
+  COMMAND tcp_link_benchmark "${PROJECT_BINARY_DIR}/tcp_link_benchmark.json"
+  DEPENDS byte_stream_benchmark reassembler_benchmark wrapping_integers_benchmark tcp_sender_benchmark
+          tcp_link_benchmark
+  WORKING_DIRECTORY "${PROJECT_BINARY_DIR}")
+
 set(compile_name_opt "compile with optimization")
 add_test(NAME ${compile_name_opt}
   COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" -t speed_testing)
@@ -89,4 +121,5 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT -1)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(byte_stream_spsc_speed_test)
 stest(reassembler_speed_test)
@@ -0,0 +1,127 @@
+#include "bitmap_ring.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using namespace std;
+
+static constexpr uint64_t WORD_BITS = 64;
+
+void BitmapRing::resize( uint64_t window )
+{
+    uint64_t new_size = (window + WORD_BITS - 1) / WORD_BITS * WORD_BITS;
+    if (new_size <= ring_.size()) return;
+
+    // byte offsets depend on the ring size, so move every held byte to its new slot
+    BitmapRing grown;
+    grown.ring_.resize(new_size);
+    grown.present_.resize(new_size / WORD_BITS);
+    grown.next_ = next_;
+    for (uint64_t index = next_; index < next_ + ring_.size(); ++index) {
+        uint64_t from = offset(index);
+        if ((present_[from / WORD_BITS] >> (from % WORD_BITS) & 1) == 0) continue;
+        grown.ring_[grown.offset(index)] = ring_[from];
+        grown.size_ += grown.mark(index, 1, true);
+    }
+    *this = move(grown);
+}
+
+uint64_t BitmapRing::mark( uint64_t index, uint64_t len, bool present )
+{
+    uint64_t changed = 0;
+    uint64_t pos = offset(index);
+    while (len > 0) {
+        // the ring size is a multiple of the word size, so a word never straddles the wraparound
+        uint64_t bit = pos % WORD_BITS;
+        uint64_t n = min(len, WORD_BITS - bit);
+        uint64_t mask = (n == WORD_BITS ? ~uint64_t {0} : (uint64_t {1} << n) - 1) << bit;
+        uint64_t& word = present_[pos / WORD_BITS];
+        uint64_t updated = present ? word | mask : word & ~mask;
+        changed += popcount(word ^ updated);
+        word = updated;
+
+        pos += n;
+        if (pos == ring_.size()) pos = 0;
+        len -= n;
+    }
+    return changed;
+}
+
+uint64_t BitmapRing::run_length() const
+{
+    uint64_t pos = offset(next_);
+    uint64_t len = 0;
+    while (len < ring_.size()) {
+        uint64_t bit = pos % WORD_BITS;
+        uint64_t ones = countr_one(present_[pos / WORD_BITS] >> bit);
+        len += min(ones, WORD_BITS - bit);
+        if (ones < WORD_BITS - bit) break;
+
+        pos += WORD_BITS - bit;
+        if (pos == ring_.size()) pos = 0;
+    }
+    return min(len, ring_.size());
+}
+
+void BitmapRing::insert( uint64_t first_index, string_view data, uint64_t window )
+{
+    if (data.empty()) return;
+    resize(window);
+
+    uint64_t pos = offset(first_index);
+    uint64_t first = min(data.size(), ring_.size() - pos);
+    memcpy(ring_.data() + pos, data.data(), first);
+    memcpy(ring_.data(), data.data() + first, data.size() - first);
+    size_ += mark(first_index, data.size(), true);
+}
+
+void BitmapRing::ranges( uint64_t max_ranges, vector<ByteRange>& out ) const
+{
+    if (size_ == 0) return;
+
+    // walk the window [next_, next_ + ring size) down a word at a time, skipping empty words
+    RangeCollector collector(out, max_ranges);
+    uint64_t index = next_ + ring_.size();
+    while (index > next_ && !collector.full()) {
+        uint64_t pos = offset(index - 1);
+        uint64_t bit = pos % WORD_BITS;
+        uint64_t len = min(bit + 1, index - next_);
+        uint64_t chunk = present_[pos / WORD_BITS] >> (bit + 1 - len);
+        if (len < WORD_BITS) chunk &= (uint64_t {1} << len) - 1;
+        index -= len;
+        if (chunk != 0) collector.feed(index, chunk, len);
+    }
+    collector.finish();
+}
+
+uint64_t BitmapRing::flush( uint64_t index, Writer& output )
+{
+    if (ring_.empty()) {
+        next_ = index;
+        return index;
+    }
+
+    // forget whatever was delivered some other way
+    if (index > next_) {
+        if (index - next_ >= ring_.size()) {
+            fill(present_.begin(), present_.end(), 0);
+            size_ = 0;
+        }
+        else {
+            size_ -= mark(next_, index - next_, false);
+        }
+        next_ = index;
+    }
+
+    // copy the run at the front straight from the ring into the stream's free space
+    uint64_t len = run_length();
+    uint64_t pos = offset(next_);
+    uint64_t first = min(len, ring_.size() - pos);
+    uint64_t copied = write(output, string_view(ring_).substr(pos, first));
+    if (copied == first) copied += write(output, string_view(ring_).substr(0, len - first));
+
+    size_ -= mark(next_, copied, false);
+    next_ += copied;
+    return next_;
+}
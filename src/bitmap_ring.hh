@@ -0,0 +1,40 @@
+#pragma once
+
+#include "byte_range.hh"
+#include "byte_stream.hh"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reassembler storage made of one ring of bytes, covering the stream's window, plus one presence bit
+// per byte. Byte `i` of the stream lives at ring offset `i % ring size`; out-of-order data is copied
+// straight to its slot, and the contiguous run at the front is found 64 bits at a time and copied
+// from the ring straight into the Writer's storage. The ring is sized lazily to the largest window
+// seen (normally the stream's capacity on the first insert), so memory per connection is fixed and
+// nothing is allocated per segment.
+class BitmapRing
+{
+    std::string ring_ {};
+    std::vector<uint64_t> present_ {}; // bit `j` of word `k` is set if ring offset 64 * k + j holds a byte
+    uint64_t next_ = 0;                // stream index of the first byte that may be held
+    uint64_t size_ = 0;                // number of bytes held
+
+    uint64_t offset( uint64_t index ) const { return index % ring_.size(); }
+    void resize( uint64_t window ); // Grow the ring to cover at least `window` bytes after next_
+    uint64_t mark( uint64_t index, uint64_t len, bool present ); // Set or clear presence bits, return
+                                                                 // how many of them changed
+    uint64_t run_length() const; // Number of bytes held contiguously from next_
+
+public:
+    // Hold the bytes of `data`, which must lie within `window` bytes of the last flushed index
+    void insert( uint64_t first_index, std::string_view data, uint64_t window );
+    uint64_t flush( uint64_t index, Writer& output ); // Drop bytes before `index`, push the run starting there,
+                                                      // return the index just past what was pushed
+
+    // Append the highest `max_ranges` ranges of held bytes, highest first
+    void ranges( uint64_t max_ranges, std::vector<ByteRange>& out ) const;
+
+    uint64_t size() const { return size_; }
+};
@@ -0,0 +1,40 @@
+#include "byte_range.hh"
+
+#include <algorithm>
+#include <bit>
+
+using namespace std;
+
+void RangeCollector::emit( uint64_t begin )
+{
+    if (run_end_.has_value() && remaining_ > 0) {
+        ranges_.push_back({ begin, run_end_.value() });
+        --remaining_;
+    }
+    run_end_.reset();
+}
+
+void RangeCollector::feed( uint64_t base, uint64_t bits, uint64_t len )
+{
+    // a run open at the bottom of the previous chunk ends there if this chunk does not continue it
+    if (lowest_.has_value() && base + len != lowest_.value()) emit(lowest_.value());
+    lowest_ = base;
+
+    uint64_t left = len; // bits [0, left) of the chunk are still to be scanned, from the top down
+    while (left > 0 && !full()) {
+        uint64_t top = bits << (64 - left); // bit left - 1 of the chunk moved to bit 63
+        if (run_end_.has_value()) {
+            left -= min<uint64_t>(countl_one(top), left);
+            if (left > 0) emit(base + left);
+        }
+        else {
+            left -= min<uint64_t>(countl_zero(top), left);
+            if (left > 0) run_end_ = base + left;
+        }
+    }
+}
+
+void RangeCollector::finish()
+{
+    if (lowest_.has_value()) emit(lowest_.value());
+}
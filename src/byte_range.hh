@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// The stream indices [begin, end)
+struct ByteRange
+{
+    uint64_t begin {};
+    uint64_t end {};
+
+    bool operator==( const ByteRange& other ) const = default;
+};
+
+// Turns presence bits, fed from the highest indices down, into the ranges of set bits, highest
+// first, and stops once it has `max_ranges` of them. Adjacent chunks merge their runs.
+class RangeCollector
+{
+    std::vector<ByteRange>& ranges_;
+    uint64_t remaining_;                  // ranges still wanted
+    std::optional<uint64_t> run_end_ {};  // end of the run being scanned, if it has not ended yet
+    std::optional<uint64_t> lowest_ {};   // lowest index fed so far
+
+    void emit( uint64_t begin );
+
+public:
+    RangeCollector( std::vector<ByteRange>& ranges, uint64_t max_ranges )
+        : ranges_( ranges ), remaining_( max_ranges ) {}
+
+    bool full() const { return remaining_ == 0; }
+
+    // Bit j of `bits` (j < len <= 64) tells whether index base + j is present. Chunks must be fed
+    // in decreasing order of base, and not overlap.
+    void feed( uint64_t base, uint64_t bits, uint64_t len );
+    void finish(); // Close the run still open at the lowest index fed
+};
@@ -1,87 +1,211 @@
-#include <stdexcept>
-
-#include "byte_stream.hh"
-
-using namespace std;
-
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), buffer(string()) {}
-
-void Writer::push( string data )
-{
-    // Your code here.
-    if (closed_) set_error();
-    unsigned availableSpace = available_capacity();
-
-    availableSpace = availableSpace < data.size()? availableSpace : data.size();
-    for (unsigned i = 0; i < availableSpace; ++i)
-        buffer.push_back(data[i]);
-
-    pushed_count_ += availableSpace;
-}
-
-void Writer::close()
-{
-    // Your code here.
-    closed_ = true;
-}
-
-void Writer::set_error()
-{
-  // Your code here.
-    error_ = true;
-}
-
-bool Writer::is_closed() const
-{
-    // Your code here.
-    return closed_;
-}
-
-uint64_t Writer::available_capacity() const
-{
-    // Your code here.
-    return capacity_ - buffer.size();
-}
-
-uint64_t Writer::bytes_pushed() const
-{
-    // Your code here.
-    return pushed_count_;
-}
-
-string_view Reader::peek() const
-{
-    // Your code here.
-    return string_view(buffer);
-}
-
-bool Reader::is_finished() const
-{
-    // Your code here.
-    return closed_ && buffer.empty();
-}
-
-bool Reader::has_error() const
-{
-    // Your code here.
-    return error_;
-}
-
-void Reader::pop( uint64_t len )
-{
-    int actual_len = len < buffer.size()? len:buffer.size();
-    buffer = buffer.substr(actual_len, buffer.size());
-    popped_count_ += len;
-}
-
-uint64_t Reader::bytes_buffered() const
-{
-    // Your code here.
-    return buffer.size();
-}
-
-uint64_t Reader::bytes_popped() const
-{
-    // Your code here.
-    return popped_count_;
-}
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+
+using namespace std;
+
+static variant<RingBuffer, ChunkQueue, MappedRing> make_storage( uint64_t capacity, StreamStorage storage )
+{
+    switch (storage) {
+    case StreamStorage::Chunked: return ChunkQueue(capacity);
+    case StreamStorage::Mapped: return MappedRing(capacity);
+    default: return RingBuffer(capacity);
+    }
+}
+
+ByteStream::ByteStream( uint64_t capacity, StreamStorage storage )
+    : capacity_( capacity ), buffer_( make_storage(capacity, storage) ) {}
+
+void Writer::push( string data )
+{
+    // Your code here.
+    if (closed_) set_error();
+    pushed_count_ += visit([&](auto& buffer) { return buffer.push(move(data)); }, buffer_);
+    wake_waiters();
+}
+
+span<char> Writer::reserve( uint64_t len )
+{
+    if (closed_) {
+        set_error();
+        return {};
+    }
+    return visit([&](auto& buffer) { return buffer.reserve(len); }, buffer_);
+}
+
+void Writer::commit( uint64_t len )
+{
+    uint64_t before = available_capacity();
+    visit([&](auto& buffer) { buffer.commit(len); }, buffer_);
+    pushed_count_ += before - available_capacity();
+    wake_waiters();
+}
+
+uint64_t Writer::fill_from( FileDescriptor& fd )
+{
+    if (closed_) {
+        set_error();
+        return 0;
+    }
+    vector<span<char>> spans;
+    visit([&](auto& buffer) { buffer.reserve_all(spans); }, buffer_);
+    if (spans.empty()) return 0;
+
+    uint64_t len = fd.read(spans);
+    commit(len);
+    return len;
+}
+
+void Writer::close()
+{
+    // Your code here.
+    closed_ = true;
+    wake_waiters();
+}
+
+void Writer::set_error()
+{
+  // Your code here.
+    error_ = true;
+    wake_waiters();
+}
+
+bool Writer::is_closed() const
+{
+    // Your code here.
+    return closed_;
+}
+
+uint64_t Writer::available_capacity() const
+{
+    // Your code here.
+    return visit([](const auto& buffer) { return buffer.available(); }, buffer_);
+}
+
+uint64_t Writer::bytes_pushed() const
+{
+    // Your code here.
+    return pushed_count_;
+}
+
+string_view Reader::peek() const
+{
+    // Your code here.
+    return visit([](const auto& buffer) { return buffer.peek(); }, buffer_);
+}
+
+vector<string_view> Reader::peek_all() const
+{
+    vector<string_view> views;
+    visit([&](const auto& buffer) { buffer.peek_all(views); }, buffer_);
+    return views;
+}
+
+BufferSlice Reader::peek_slice( uint64_t offset, uint64_t len ) const
+{
+    offset = min(offset, bytes_buffered());
+    len = min(len, bytes_buffered() - offset);
+    if (len == 0) return {};
+
+    if (const auto* chunks = get_if<ChunkQueue>(&buffer_)) {
+        if (auto slice = chunks->slice(offset, len)) return move(*slice);
+    }
+
+    // the other storages reuse their space once bytes are popped, so the slice needs its own copy
+    string_view front = peek();
+    if (offset + len <= front.size()) return string(front.substr(offset, len));
+
+    string copy;
+    copy.reserve(len);
+    for (string_view view : peek_all()) {
+        if (offset >= view.size()) {
+            offset -= view.size();
+            continue;
+        }
+        copy += view.substr(offset, len - copy.size());
+        offset = 0;
+        if (copy.size() == len) break;
+    }
+    return copy;
+}
+
+bool Reader::is_finished() const
+{
+    // Your code here.
+    return closed_ && bytes_buffered() == 0;
+}
+
+bool Reader::has_error() const
+{
+    // Your code here.
+    return error_;
+}
+
+void Reader::pop( uint64_t len )
+{
+    uint64_t actual_len = min(len, bytes_buffered());
+    visit([&](auto& buffer) { buffer.pop(actual_len); }, buffer_);
+    popped_count_ += actual_len;
+    wake_waiters();
+}
+
+uint64_t Reader::drain_to( FileDescriptor& fd )
+{
+    vector<string_view> views = peek_all();
+    if (views.empty()) return 0;
+
+    uint64_t len = fd.write(views);
+    pop(len);
+    return len;
+}
+
+uint64_t Reader::bytes_buffered() const
+{
+    // Your code here.
+    return visit([](const auto& buffer) { return buffer.size(); }, buffer_);
+}
+
+uint64_t Reader::bytes_popped() const
+{
+    // Your code here.
+    return popped_count_;
+}
+
+void ByteStream::wake_waiters()
+{
+    // a resumed coroutine may push, pop or start waiting again, so detach each handle before resuming it
+    if (read_waiter_.handle
+        && (closed_ || error_ || reader().bytes_buffered() >= read_waiter_.threshold)) {
+        exchange(read_waiter_.handle, nullptr).resume();
+    }
+    if (write_waiter_.handle && (error_ || writer().available_capacity() >= write_waiter_.threshold)) {
+        exchange(write_waiter_.handle, nullptr).resume();
+    }
+}
+
+bool Reader::Readable::await_ready() const
+{
+    return reader.closed_ || reader.error_ || reader.bytes_buffered() >= min(len, reader.capacity_);
+}
+
+void Reader::Readable::await_suspend( coroutine_handle<> handle )
+{
+    if (reader.read_waiter_.handle) throw runtime_error("Reader::readable: another coroutine is already waiting");
+    reader.read_waiter_.handle = handle;
+    reader.read_waiter_.threshold = min(len, reader.capacity_);
+}
+
+bool Writer::Writable::await_ready() const
+{
+    return writer.error_ || writer.available_capacity() >= min(len, writer.capacity_);
+}
+
+void Writer::Writable::await_suspend( coroutine_handle<> handle )
+{
+    if (writer.write_waiter_.handle) throw runtime_error("Writer::writable: another coroutine is already waiting");
+    writer.write_waiter_.handle = handle;
+    writer.write_waiter_.threshold = min(len, writer.capacity_);
+}
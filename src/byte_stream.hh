@@ -1,60 +1,148 @@
-#pragma once
-
-#include <queue>
-#include <stdexcept>
-#include <string>
-#include <string_view>
-#include <vector>
-
-class Reader;
-class Writer;
-
-class ByteStream {
-protected:
-    uint64_t capacity_;
-    // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
-    bool closed_ = false;
-    bool error_ = false;
-    int pushed_count_ = 0;
-    int popped_count_ = 0;
-    std::string buffer;
-
-public:
-    explicit ByteStream( uint64_t capacity );
-
-    // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
-    Reader& reader();
-    const Reader& reader() const;
-    Writer& writer();
-    const Writer& writer() const;
-};
-
-class Writer : public ByteStream{
-public:
-    void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
-
-    void close();     // Signal that the stream has reached its ending. Nothing more will be written.
-    void set_error(); // Signal that the stream suffered an error.
-
-    bool is_closed() const;              // Has the stream been closed?
-    uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
-    uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
-};
-
-class Reader : public ByteStream{
-public:
-    std::string_view peek() const; // Peek at the next bytes in the buffer
-    void pop( uint64_t len );      // Remove `len` bytes from the buffer
-
-    bool is_finished() const; // Is the stream finished (closed and fully popped)?
-    bool has_error() const;   // Has the stream had an error?
-
-    uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
-    uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
-};
-
-/*
- * read: A (provided) helper function thats peeks and pops up to `len` bytes
- * from a ByteStream Reader into a string;
- */
-void read( Reader& reader, uint64_t len, std::string& out );
+#pragma once
+
+#include "chunk_queue.hh"
+#include "mapped_ring.hh"
+#include "ring_buffer.hh"
+
+#include <coroutine>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+class FileDescriptor;
+class Reader;
+class Writer;
+
+// How a ByteStream keeps the bytes that have been pushed but not yet popped
+enum class StreamStorage : uint8_t
+{
+    Ring,    // copied into one preallocated circular buffer of `capacity` bytes
+    Chunked, // each pushed string kept by ownership, with no copy of its bytes
+    Mapped,  // copied into a double-mapped shared-memory ring, committed and released page by page
+};
+
+// A coroutine suspended until a ByteStream crosses a threshold (see Reader::readable and Writer::writable).
+// The coroutine waits on one particular stream object, so a copy of the stream starts without it.
+struct StreamWaiter
+{
+    std::coroutine_handle<> handle {};
+    uint64_t threshold = 0;
+
+    StreamWaiter() = default;
+    StreamWaiter( const StreamWaiter& /* other */ ) {}
+    StreamWaiter& operator=( const StreamWaiter& /* other */ ) { return *this; }
+    ~StreamWaiter() = default;
+};
+
+class ByteStream {
+protected:
+    uint64_t capacity_;
+    // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
+    bool closed_ = false;
+    bool error_ = false;
+    uint64_t pushed_count_ = 0;
+    uint64_t popped_count_ = 0;
+    std::variant<RingBuffer, ChunkQueue, MappedRing> buffer_;
+    StreamWaiter read_waiter_ {};  // resumed once bytes_buffered() >= threshold, or on close or error
+    StreamWaiter write_waiter_ {}; // resumed once available_capacity() >= threshold, or on error
+
+    void wake_waiters(); // Resume whichever waiting coroutines can now make progress
+
+public:
+    explicit ByteStream( uint64_t capacity, StreamStorage storage = StreamStorage::Ring );
+
+    // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
+    Reader& reader();
+    const Reader& reader() const;
+    Writer& writer();
+    const Writer& writer() const;
+};
+
+class Writer : public ByteStream{
+public:
+    void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+
+    // Two-phase push that lets a producer write straight into the stream's storage:
+    // reserve() hands out up to `len` bytes of contiguous free space (possibly fewer, e.g. at the
+    // end of the ring), and commit() appends the first `len` of them to the stream. The span is
+    // only valid until the next call that modifies the stream.
+    std::span<char> reserve( uint64_t len );
+    void commit( uint64_t len );
+
+    // Read from `fd` with one readv() straight into the stream's free space; returns bytes read
+    uint64_t fill_from( FileDescriptor& fd );
+
+    void close();     // Signal that the stream has reached its ending. Nothing more will be written.
+    void set_error(); // Signal that the stream suffered an error.
+
+    bool is_closed() const;              // Has the stream been closed?
+    uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+    uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+    // `co_await writer.writable( len )` suspends the calling coroutine until at least `len` bytes
+    // (at most the capacity) can be pushed, or the stream has an error. The coroutine is resumed from
+    // inside the Reader call that frees the space. Only one coroutine may wait on a Writer at a time.
+    struct Writable
+    {
+        Writer& writer;
+        uint64_t len;
+
+        bool await_ready() const;
+        void await_suspend( std::coroutine_handle<> handle );
+        void await_resume() const {}
+    };
+    Writable writable( uint64_t len = 1 ) { return { *this, len }; }
+};
+
+class Reader : public ByteStream{
+public:
+    std::string_view peek() const; // Peek at the next contiguous bytes in the buffer
+    std::vector<std::string_view> peek_all() const; // Peek at every buffered byte, as a list of contiguous regions
+
+    // Share up to `len` buffered bytes, starting `offset` bytes past the next one to be popped. Chunked
+    // storage hands out a slice of the chunk holding them, with no copy, when one chunk holds them all;
+    // otherwise they are copied once into a Buffer of their own.
+    BufferSlice peek_slice( uint64_t offset, uint64_t len ) const;
+    void pop( uint64_t len );      // Remove `len` bytes from the buffer
+
+    // Write buffered bytes to `fd` with one writev() straight from the stream's storage, and pop
+    // however many the kernel took; returns that number
+    uint64_t drain_to( FileDescriptor& fd );
+
+    bool is_finished() const; // Is the stream finished (closed and fully popped)?
+    bool has_error() const;   // Has the stream had an error?
+
+    uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+    uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+    // `co_await reader.readable( len )` suspends the calling coroutine until at least `len` bytes
+    // (at most the capacity) are buffered, or the stream is closed or has an error. The coroutine is
+    // resumed from inside the Writer call that crosses the mark. Only one coroutine may wait on a
+    // Reader at a time.
+    struct Readable
+    {
+        Reader& reader;
+        uint64_t len;
+
+        bool await_ready() const;
+        void await_suspend( std::coroutine_handle<> handle );
+        void await_resume() const {}
+    };
+    Readable readable( uint64_t len = 1 ) { return { *this, len }; }
+};
+
+/*
+ * read: A (provided) helper function thats peeks and pops up to `len` bytes
+ * from a ByteStream Reader into a string;
+ */
+void read( Reader& reader, uint64_t len, std::string& out );
+
+/*
+ * write: A helper function that copies as much of `data` as fits straight
+ * into a ByteStream Writer's storage, and returns how many bytes it took.
+ */
+uint64_t write( Writer& writer, std::string_view data );
@@ -1,5 +1,6 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 
@@ -10,18 +11,40 @@
 void read( Reader& reader, uint64_t len, std::string& out )
 {
   out.clear();
+  out.reserve( std::min( len, reader.bytes_buffered() ) );
 
-  while ( reader.bytes_buffered() and out.size() < len ) {
-    auto view = reader.peek();
-
+  for ( auto view : reader.peek_all() ) {
     if ( view.empty() ) {
-      throw std::runtime_error( "Reader::peek() returned empty string_view" );
+      throw std::runtime_error( "Reader::peek_all() returned empty string_view" );
+    }
+    if ( out.size() == len ) {
+      break;
+    }
+
+    out += view.substr( 0, len - out.size() ); // Don't return more bytes than desired.
+  }
+  reader.pop( out.size() );
+}
+
+/*
+ * write: A helper function that copies as much of `data` as fits straight
+ * into a ByteStream Writer's storage, and returns how many bytes it took.
+ */
+uint64_t write( Writer& writer, std::string_view data )
+{
+  uint64_t written = 0;
+  while ( written < data.size() ) {
+    const std::span<char> space = writer.reserve( data.size() - written );
+    if ( space.empty() ) {
+      break;
     }
 
-    view = view.substr( 0, len - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    reader.pop( view.size() );
+    const uint64_t len = std::min<uint64_t>( space.size(), data.size() - written );
+    std::copy_n( data.data() + written, len, space.data() );
+    writer.commit( len );
+    written += len;
   }
+  return written;
 }
 
 Reader& ByteStream::reader()
@@ -0,0 +1,97 @@
+#include "chunk_queue.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+uint64_t ChunkQueue::push( string data )
+{
+    if (data.size() > available()) {
+        // resize() keeps the whole allocation; a queued chunk that kept much more than it holds would let
+        // the stream's memory outgrow its capacity
+        if (available() < data.size() / 2) data = data.substr(0, available());
+        else data.resize(available());
+    }
+    if (data.empty()) return 0;
+
+    uint64_t len = data.size();
+    chunks_.emplace_back(move(data));
+    size_ += len;
+    return len;
+}
+
+string_view ChunkQueue::peek() const
+{
+    if (chunks_.empty()) return {};
+    return string_view(chunks_.front()).substr(front_offset_);
+}
+
+void ChunkQueue::peek_all( vector<string_view>& views ) const
+{
+    if (chunks_.empty()) return;
+    views.push_back(peek());
+    for (auto it = chunks_.begin() + 1; it != chunks_.end(); ++it) {
+        views.emplace_back(*it);
+    }
+}
+
+void ChunkQueue::pop( uint64_t len )
+{
+    len = min(len, size_);
+    size_ -= len;
+    popped_ += len;
+    while (len > 0) {
+        uint64_t left_in_front = chunks_.front().size() - front_offset_;
+        if (len < left_in_front) {
+            front_offset_ += len;
+            return;
+        }
+        len -= left_in_front;
+        chunks_.pop_front();
+        dropped_++;
+        front_offset_ = 0;
+    }
+}
+
+optional<BufferSlice> ChunkQueue::slice( uint64_t offset, uint64_t len ) const
+{
+    uint64_t target = popped_ + offset;
+    if (hint_chunk_ < dropped_ || hint_start_ > target) {
+        hint_chunk_ = dropped_;
+        hint_start_ = popped_ - front_offset_;
+    }
+
+    while (hint_chunk_ - dropped_ < chunks_.size()) {
+        const Buffer& chunk = chunks_[hint_chunk_ - dropped_];
+        if (target < hint_start_ + chunk.size()) {
+            uint64_t start = target - hint_start_;
+            if (start + len > chunk.size()) return nullopt;
+            return BufferSlice { chunk, start, len };
+        }
+        hint_start_ += chunk.size();
+        hint_chunk_++;
+    }
+    return nullopt;
+}
+
+span<char> ChunkQueue::reserve( uint64_t len )
+{
+    reserved_.resize(min(len, available()));
+    return reserved_;
+}
+
+void ChunkQueue::reserve_all( vector<span<char>>& spans )
+{
+    span<char> chunk = reserve(MAX_FILL_CHUNK);
+    if (!chunk.empty()) spans.push_back(chunk);
+}
+
+void ChunkQueue::commit( uint64_t len )
+{
+    bool mostly_unused = len < reserved_.size() / 2;
+    reserved_.resize(min(len, reserved_.size()));
+    // don't let a short read pin a mostly-empty allocation for as long as the chunk stays buffered
+    if (mostly_unused) reserved_.shrink_to_fit();
+    push(move(reserved_));
+    reserved_.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "buffer.hh"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A ByteStream storage that keeps every pushed string by ownership instead of copying its bytes.
+// Only the string that would overflow the capacity gets trimmed; popping advances an offset into
+// the front chunk and drops chunks once they have been fully read.
+class ChunkQueue
+{
+    std::deque<Buffer> chunks_ {};
+    uint64_t front_offset_ = 0; // number of bytes already popped from chunks_.front()
+    uint64_t size_ = 0;         // number of bytes currently buffered
+    uint64_t capacity_;
+    std::string reserved_ {}; // chunk handed out by reserve(), waiting to be committed
+    uint64_t popped_ = 0;     // number of bytes ever popped
+    uint64_t dropped_ = 0;    // number of chunks ever dropped off the front
+
+    // the chunk slice() found last, as its number (counting dropped chunks) and the stream position
+    // of its first byte, so that walking forward through the buffered bytes costs O(1) per slice
+    mutable uint64_t hint_chunk_ = 0;
+    mutable uint64_t hint_start_ = 0;
+
+    static constexpr uint64_t MAX_FILL_CHUNK = 65536; // largest chunk reserve_all() allocates at once
+
+public:
+    explicit ChunkQueue( uint64_t capacity ) : capacity_( capacity ) {}
+
+    uint64_t push( std::string data ); // Take ownership of as much of `data` as fits, return how many bytes
+    std::string_view peek() const;     // The unread part of the front chunk
+    void peek_all( std::vector<std::string_view>& views ) const; // Append the unread part of every chunk, in order
+    void pop( uint64_t len );          // Discard up to `len` bytes from the front
+
+    // Share the `len` bytes starting `offset` bytes past the front, if one chunk holds all of them
+    std::optional<BufferSlice> slice( uint64_t offset, uint64_t len ) const;
+
+    std::span<char> reserve( uint64_t len ); // A fresh chunk of up to `len` bytes to be filled in place
+    void reserve_all( std::vector<std::span<char>>& spans ); // Reserve a chunk for (most of) the free space
+    void commit( uint64_t len );             // Append the first `len` bytes of the reserved chunk
+
+    uint64_t size() const { return size_; }
+    uint64_t capacity() const { return capacity_; }
+    uint64_t available() const { return capacity_ - size_; }
+};
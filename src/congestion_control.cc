@@ -0,0 +1,181 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+CongestionController make_congestion_controller( CongestionControl algorithm )
+{
+    switch (algorithm) {
+        case CongestionControl::NewReno: return NewReno();
+        case CongestionControl::Cubic: return Cubic();
+        case CongestionControl::BbrLite: return BbrLite();
+        case CongestionControl::None: break;
+    }
+    return UnlimitedWindow();
+}
+
+void NewReno::on_ack( const AckSample& sample )
+{
+    if (sample.in_recovery) {
+        return;
+    }
+
+    // slow start: a segment more per segment acked, so the window doubles every round trip
+    if (cwnd_ < ssthresh_) {
+        cwnd_ += min(sample.acked, CC_MSS);
+        return;
+    }
+
+    // congestion avoidance: a segment more once a whole window has been acked
+    acked_in_avoidance_ += sample.acked;
+    if (acked_in_avoidance_ >= cwnd_) {
+        acked_in_avoidance_ -= cwnd_;
+        cwnd_ += CC_MSS;
+    }
+}
+
+void NewReno::on_loss( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+    ssthresh_ = max(in_flight / 2, 2 * CC_MSS);
+    cwnd_ = ssthresh_;
+    acked_in_avoidance_ = 0;
+}
+
+void NewReno::on_timeout( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+    ssthresh_ = max(in_flight / 2, 2 * CC_MSS);
+    cwnd_ = CC_MSS;
+    acked_in_avoidance_ = 0;
+}
+
+void Cubic::on_ack( const AckSample& sample )
+{
+    if (sample.in_recovery) {
+        return;
+    }
+    if (cwnd_ < static_cast<double>(ssthresh_)) {
+        cwnd_ += static_cast<double>(min(sample.acked, CC_MSS));
+        return;
+    }
+
+    // the first ack in congestion avoidance starts the epoch the curve is measured from
+    if (!epoch_start_) {
+        epoch_start_ = sample.now_ms;
+        w_est_ = cwnd_;
+        if (cwnd_ < w_max_) {
+            k_ = cbrt((w_max_ - cwnd_) / CC_MSS / C);
+            origin_ = w_max_;
+        }
+        else {
+            k_ = 0;
+            origin_ = cwnd_;
+        }
+    }
+
+    double t = static_cast<double>(sample.now_ms - *epoch_start_) / 1000 - k_;
+    double target = origin_ + C * t * t * t * CC_MSS;
+    w_est_ += ALPHA * CC_MSS * static_cast<double>(sample.acked) / cwnd_;
+
+    // grow toward the target at most by half again per round trip, and never slower than Reno
+    target = min(max(target, w_est_), 1.5 * cwnd_);
+    if (target > cwnd_) {
+        cwnd_ += (target - cwnd_) * static_cast<double>(sample.acked) / cwnd_;
+    }
+}
+
+void Cubic::on_loss( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+    // fast convergence: a loss below the last maximum suggests a new flow is taking its share
+    w_max_ = cwnd_ < w_max_ ? cwnd_ * (1 + BETA) / 2 : cwnd_;
+    ssthresh_ = max(static_cast<uint64_t>(cwnd_ * BETA), 2 * CC_MSS);
+    cwnd_ = static_cast<double>(ssthresh_);
+    epoch_start_.reset();
+}
+
+void Cubic::on_timeout( uint64_t in_flight, uint64_t now_ms )
+{
+    on_loss(in_flight, now_ms);
+    cwnd_ = CC_MSS;
+}
+
+double BbrLite::bottleneck_bw() const
+{
+    return *max_element(round_bw_.begin(), round_bw_.end());
+}
+
+void BbrLite::record_delivery( uint64_t acked, uint64_t now_ms )
+{
+    // nothing was delivered in the milliseconds since the last ack
+    for (uint64_t ms = max(history_ms_ + 1, now_ms >= HISTORY_MS ? now_ms - HISTORY_MS + 1 : 0); ms < now_ms; ++ms) {
+        delivered_at_[ms % HISTORY_MS] = delivered_;
+    }
+    delivered_ += acked;
+    delivered_at_[now_ms % HISTORY_MS] = delivered_;
+    history_ms_ = now_ms;
+}
+
+void BbrLite::end_round( uint64_t now_ms )
+{
+    round_ += 1;
+    round_start_ms_ = now_ms;
+    round_bw_[round_ % BW_WINDOW_ROUNDS] = 0;
+
+    // startup ends once three rounds in a row fail to raise the bandwidth by a quarter
+    if (startup_) {
+        if (bottleneck_bw() >= full_bw_ * 1.25) {
+            full_bw_ = bottleneck_bw();
+            full_bw_count_ = 0;
+        }
+        else if (++full_bw_count_ >= 3) {
+            startup_ = false;
+        }
+    }
+}
+
+void BbrLite::on_ack( const AckSample& sample )
+{
+    uint64_t delivered_before = delivered_;
+    record_delivery(sample.acked, sample.now_ms);
+
+    if (sample.rtt_ms) {
+        uint64_t rtt = max<uint64_t>(*sample.rtt_ms, 1);
+        if (rtt <= min_rtt_ms_ || sample.now_ms - min_rtt_stamp_ms_ > MIN_RTT_WINDOW_MS) {
+            min_rtt_ms_ = rtt;
+            min_rtt_stamp_ms_ = sample.now_ms;
+        }
+
+        // the delivery rate while this segment was in flight: what was acked between its send and its ack
+        if (rtt < HISTORY_MS && sample.now_ms >= rtt) {
+            uint64_t delivered_when_sent = min(delivered_at_[(sample.now_ms - rtt) % HISTORY_MS], delivered_before);
+            double rate = static_cast<double>(delivered_ - delivered_when_sent) / static_cast<double>(rtt);
+            round_bw_[round_ % BW_WINDOW_ROUNDS] = max(round_bw_[round_ % BW_WINDOW_ROUNDS], rate);
+        }
+    }
+
+    // a round is one min RTT long; until there is an RTT sample there is no model to follow
+    if (min_rtt_ms_ != UINT64_MAX && sample.now_ms - round_start_ms_ >= min_rtt_ms_) {
+        end_round(sample.now_ms);
+    }
+    if (startup_ || min_rtt_ms_ == UINT64_MAX) {
+        cwnd_ += sample.acked;
+        return;
+    }
+
+    double gain = GAIN_CYCLE[round_ % GAIN_CYCLE.size()];
+    double bdp = bottleneck_bw() * static_cast<double>(min_rtt_ms_);
+    cwnd_ = max(static_cast<uint64_t>(gain * bdp), 4 * CC_MSS);
+}
+
+void BbrLite::on_loss( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+    // the model takes no notice of a loss the sender repairs without a timeout
+}
+
+void BbrLite::on_timeout( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+    // the model survives a loss; the window is rebuilt from it on the next ack
+    startup_ = false;
+    cwnd_ = CC_MSS;
+}
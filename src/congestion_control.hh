@@ -0,0 +1,126 @@
+#pragma once
+
+#include "tcp_config.hh"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <variant>
+
+// Which congestion-control algorithm a TCPSender runs
+enum class CongestionControl : uint8_t
+{
+    None,    // send as much as the receiver's window allows
+    NewReno, // slow start, then one segment more per round trip; halved on a loss, one segment on a timeout
+    Cubic,   // window grows as a cubic function of the time since the last loss (RFC 9438)
+    BbrLite, // window sized from the measured bottleneck bandwidth and min RTT (a simplified BBR)
+};
+
+// What the sender learned from an ACK that acknowledged new data
+struct AckSample
+{
+    uint64_t acked = 0;                // sequence numbers newly acknowledged
+    uint64_t in_flight = 0;            // sequence numbers still outstanding afterwards
+    uint64_t now_ms = 0;               // the sender's clock: the sum of every tick() so far
+    std::optional<uint64_t> rtt_ms {}; // round trip of the newest acked segment, unless it was retransmitted
+    bool in_recovery = false;          // the sender is still repairing a loss found by on_loss()
+};
+
+// Every algorithm is a class with the same four members, and the sender keeps one of them in a
+// std::variant: window() bounds how many sequence numbers may be outstanding, on_ack(), on_loss() (a
+// loss found by duplicate acks or SACK, once per recovery) and on_timeout() feed it what the sender
+// sees. Windows are in bytes (sequence numbers).
+constexpr uint64_t CC_MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint64_t CC_INITIAL_WINDOW = 10 * CC_MSS; // RFC 6928
+
+class UnlimitedWindow
+{
+public:
+    uint64_t window() const { return UINT64_MAX; }
+    void on_ack( const AckSample& /* sample */ ) {}
+    void on_loss( uint64_t /* in_flight */, uint64_t /* now_ms */ ) {}
+    void on_timeout( uint64_t /* in_flight */, uint64_t /* now_ms */ ) {}
+};
+
+// Reno's additive increase, multiplicative decrease (RFC 5681, RFC 6582): a loss the sender recovers
+// from halves the window, which holds until the recovery is over; a timeout restarts slow start from
+// one segment.
+class NewReno
+{
+    uint64_t cwnd_ = CC_INITIAL_WINDOW;
+    uint64_t ssthresh_ = UINT64_MAX;
+    uint64_t acked_in_avoidance_ = 0; // bytes acked since the window last grew in congestion avoidance
+
+public:
+    uint64_t window() const { return cwnd_; }
+    void on_ack( const AckSample& sample );
+    void on_loss( uint64_t in_flight, uint64_t now_ms );
+    void on_timeout( uint64_t in_flight, uint64_t now_ms );
+};
+
+// CUBIC (RFC 9438): after a loss the window climbs back to where the loss happened along a cubic
+// curve (fast, then flat around the old maximum, then fast again), never slower than Reno would.
+class Cubic
+{
+    static constexpr double C = 0.4;    // in segments per second cubed
+    static constexpr double BETA = 0.7; // multiplicative decrease
+    static constexpr double ALPHA = 3 * ( 1 - BETA ) / ( 1 + BETA ); // Reno-friendly additive increase
+
+    double cwnd_ = CC_INITIAL_WINDOW;
+    uint64_t ssthresh_ = UINT64_MAX;
+    double w_max_ = 0;                      // window at the last loss
+    std::optional<uint64_t> epoch_start_ {}; // when congestion avoidance began after the last loss
+    double k_ = 0;                          // seconds from the epoch start until the curve reaches its origin
+    double origin_ = 0;                     // the window the curve flattens out at
+    double w_est_ = 0;                      // what Reno would have grown the window to in this epoch
+
+public:
+    uint64_t window() const { return static_cast<uint64_t>( cwnd_ ); }
+    void on_ack( const AckSample& sample );
+    void on_loss( uint64_t in_flight, uint64_t now_ms );
+    void on_timeout( uint64_t in_flight, uint64_t now_ms );
+};
+
+// A model-based controller in the style of BBR, without pacing: it measures the bottleneck bandwidth
+// (the highest delivery rate seen over the last few rounds) and the minimum RTT, and keeps the window
+// at their product, times a gain that cycles to probe for more bandwidth and then drain the queue.
+// It starts by doubling the window each round until the bandwidth stops growing.
+class BbrLite
+{
+    static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+    static constexpr uint64_t HISTORY_MS = 1024; // RTTs longer than this give no delivery-rate sample
+    static constexpr std::array<double, 8> GAIN_CYCLE { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+
+    uint64_t cwnd_ = CC_INITIAL_WINDOW;
+    bool startup_ = true;
+    double full_bw_ = 0;         // bandwidth when it last grew by a quarter, during startup
+    uint64_t full_bw_count_ = 0; // rounds since then
+
+    uint64_t min_rtt_ms_ = UINT64_MAX;
+    uint64_t min_rtt_stamp_ms_ = 0;
+
+    // total bytes acked as of each of the last HISTORY_MS milliseconds, indexed by time % HISTORY_MS, so an
+    // RTT sample tells how much was delivered while that segment was in flight
+    std::array<uint64_t, HISTORY_MS> delivered_at_ {};
+    uint64_t delivered_ = 0;
+    uint64_t history_ms_ = 0; // the last millisecond delivered_at_ covers
+
+    std::array<double, BW_WINDOW_ROUNDS> round_bw_ {}; // highest delivery rate (bytes per ms) of recent rounds
+    uint64_t round_ = 0;
+    uint64_t round_start_ms_ = 0;
+
+    double bottleneck_bw() const;
+    void record_delivery( uint64_t acked, uint64_t now_ms );
+    void end_round( uint64_t now_ms );
+
+public:
+    uint64_t window() const { return cwnd_; }
+    void on_ack( const AckSample& sample );
+    void on_loss( uint64_t in_flight, uint64_t now_ms );
+    void on_timeout( uint64_t in_flight, uint64_t now_ms );
+};
+
+using CongestionController = std::variant<UnlimitedWindow, NewReno, Cubic, BbrLite>;
+
+CongestionController make_congestion_controller( CongestionControl algorithm );
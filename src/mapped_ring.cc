@@ -0,0 +1,159 @@
+#include "mapped_ring.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+MappedRing::MappedRing( uint64_t capacity ) : capacity_( capacity )
+{
+    map();
+}
+
+MappedRing::~MappedRing()
+{
+    unmap();
+}
+
+void MappedRing::map()
+{
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    size_ring_ = (capacity_ + page_size - 1) / page_size * page_size;
+    if (size_ring_ == 0) return;
+
+    int fd = CheckSystemCall("memfd_create", memfd_create("byte_stream", MFD_CLOEXEC));
+    try {
+        CheckSystemCall("ftruncate", ftruncate(fd, static_cast<off_t>(size_ring_)));
+
+        // reserve the whole range first, then map the same file over both halves of it
+        void* base = mmap(nullptr, 2 * size_ring_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) throw unix_error("mmap");
+        base_ = static_cast<char*>(base);
+        for (char* half : {base_, base_ + size_ring_}) {
+            if (mmap(half, size_ring_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+                throw unix_error("mmap");
+            }
+        }
+    } catch (...) {
+        unmap();
+        close(fd);
+        throw;
+    }
+    // the mappings keep the memory alive
+    close(fd);
+}
+
+void MappedRing::unmap()
+{
+    if (base_) munmap(base_, 2 * size_ring_);
+    base_ = nullptr;
+}
+
+MappedRing::MappedRing( const MappedRing& other ) : capacity_( other.capacity_ ), size_( other.size_ )
+{
+    map();
+    if (size_ > 0) memcpy(base_, other.peek().data(), size_);
+}
+
+MappedRing& MappedRing::operator=( const MappedRing& other )
+{
+    if (this != &other) *this = MappedRing(other);
+    return *this;
+}
+
+MappedRing::MappedRing( MappedRing&& other ) noexcept
+    : capacity_( other.capacity_ ), size_ring_( other.size_ring_ ), base_( exchange(other.base_, nullptr) ),
+      popped_( other.popped_ ), size_( other.size_ ), reserved_( other.reserved_ ), released_( other.released_ ) {}
+
+MappedRing& MappedRing::operator=( MappedRing&& other ) noexcept
+{
+    if (this != &other) {
+        unmap();
+        capacity_ = other.capacity_;
+        size_ring_ = other.size_ring_;
+        base_ = exchange(other.base_, nullptr);
+        popped_ = other.popped_;
+        size_ = other.size_;
+        reserved_ = other.reserved_;
+        released_ = other.released_;
+    }
+    return *this;
+}
+
+uint64_t MappedRing::tail() const
+{
+    uint64_t tail = head() + size_;
+    if (tail >= size_ring_) tail -= size_ring_;
+    return tail;
+}
+
+uint64_t MappedRing::push( string_view data )
+{
+    reserved_ = 0;
+    uint64_t len = min(data.size(), available());
+    if (len == 0) return 0;
+    memcpy(base_ + tail(), data.data(), len);
+    size_ += len;
+    return len;
+}
+
+string_view MappedRing::peek() const
+{
+    if (size_ == 0) return {};
+    return { base_ + head(), size_ };
+}
+
+void MappedRing::peek_all( vector<string_view>& views ) const
+{
+    if (size_ > 0) views.push_back(peek());
+}
+
+void MappedRing::pop( uint64_t len )
+{
+    reserved_ = 0;
+    len = min(len, size_);
+    size_ -= len;
+    popped_ += len;
+    release_consumed_pages();
+}
+
+void MappedRing::release_consumed_pages()
+{
+    if (size_ring_ <= RELEASE_BATCH) return;
+
+    // Stream offset q was stored in the same ring slot as q + size_ring_, so a consumed offset is
+    // only free if that later offset hasn't been pushed yet. Release whole pages of those.
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t pushed = popped_ + size_;
+    uint64_t begin = max(released_, pushed > size_ring_ ? pushed - size_ring_ : 0);
+    begin = (begin + page_size - 1) / page_size * page_size;
+    uint64_t end = popped_ / page_size * page_size;
+    if (end < begin + RELEASE_BATCH) return;
+
+    // the range is at most one ring long, so it fits in the double mapping from its start
+    madvise(base_ + begin % size_ring_, end - begin, MADV_REMOVE);
+    released_ = end;
+}
+
+span<char> MappedRing::reserve( uint64_t len )
+{
+    reserved_ = min(len, available());
+    return { base_ + tail(), reserved_ };
+}
+
+void MappedRing::reserve_all( vector<span<char>>& spans )
+{
+    span<char> free_space = reserve(available());
+    if (!free_space.empty()) spans.push_back(free_space);
+}
+
+void MappedRing::commit( uint64_t len )
+{
+    size_ += min(len, reserved_);
+    reserved_ = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// A ByteStream storage for very large capacities: a ring of shared memory mapped twice, back to back,
+// into one virtual address range (a "magic ring buffer"). Byte i of the ring is visible both at
+// base + i and at base + size + i, so the buffered bytes and the free space are always contiguous,
+// even across the wraparound: peek() returns everything buffered and push() is a single memcpy.
+//
+// The memory is a memfd, so pages are only committed when the writer first touches them. As the
+// reader advances, pages it has fully consumed are handed back to the kernel in batches of
+// RELEASE_BATCH bytes (MADV_REMOVE, since MADV_DONTNEED would leave a shared mapping's pages resident),
+// keeping the resident size close to what is actually buffered.
+class MappedRing
+{
+    uint64_t capacity_;      // logical capacity of the stream
+    uint64_t size_ring_ = 0; // size of one mapping: capacity_ rounded up to whole pages
+    char* base_ = nullptr;   // start of the 2 * size_ring_ bytes of address space
+    uint64_t popped_ = 0;    // number of bytes ever popped; the head is at popped_ % size_ring_
+    uint64_t size_ = 0;      // number of bytes currently buffered
+    uint64_t reserved_ = 0;  // length of the span handed out by the last reserve()
+    uint64_t released_ = 0;  // stream offset below which consumed pages have been released
+
+    static constexpr uint64_t RELEASE_BATCH = 1 << 20;
+
+    void map();
+    void unmap();
+    uint64_t head() const { return size_ring_ ? popped_ % size_ring_ : 0; }
+    uint64_t tail() const;
+    void release_consumed_pages();
+
+public:
+    explicit MappedRing( uint64_t capacity );
+    ~MappedRing();
+
+    MappedRing( const MappedRing& other );
+    MappedRing& operator=( const MappedRing& other );
+    MappedRing( MappedRing&& other ) noexcept;
+    MappedRing& operator=( MappedRing&& other ) noexcept;
+
+    uint64_t push( std::string_view data ); // Copy as much of `data` as fits, return how many bytes were taken
+    std::string_view peek() const;          // Every buffered byte, always in one piece
+    void peek_all( std::vector<std::string_view>& views ) const; // Append the single buffered region
+    void pop( uint64_t len );               // Discard up to `len` bytes from the head
+
+    std::span<char> reserve( uint64_t len ); // Up to `len` bytes of free space right after the tail
+    void reserve_all( std::vector<std::span<char>>& spans ); // Reserve all free space, as one span
+    void commit( uint64_t len );             // Make the first `len` reserved bytes part of the buffer
+
+    uint64_t size() const { return size_; }
+    uint64_t capacity() const { return capacity_; }
+    uint64_t available() const { return capacity_ - size_; }
+};
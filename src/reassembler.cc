@@ -1,94 +1,130 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <vector>
+
 using namespace std;
 
+Reassembler::Reassembler( ReassemblerStorage storage )
+{
+    if (storage == ReassemblerStorage::Bitmap) pending = BitmapRing();
+}
+
+Reassembler::Reassembler( ReassemblerPool& pool ) : pending( PooledSegments(pool) ) {}
+
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
 {
-    long unsigned int capacity = output.available_capacity();
-    if (first_index <= current_index) {
-        if (first_index + data.length() > current_index) {
-            int start = current_index - first_index;
-            int len = min(data.length() - start, capacity);
-            output.push(data.substr(start, len));
-            current_index += len;
-            update_buffer(output);
+    if (is_last_substring) end_index = first_index + data.size();
+
+    auto [begin, end] = useful_range(first_index, data.size(), output);
+    if (begin < end) {
+        string_view useful = string_view(data).substr(begin - first_index, end - begin);
+        if (begin == current_index) deliver(useful, output);
+        else if (holds_alternative<SegmentMap>(pending)) {
+            // the map holds slices, so give it the string itself rather than a copy of the useful part
+            get<SegmentMap>(pending).insert(begin, { Buffer(move(data)), begin - first_index, end - begin });
         }
-    }
-    else if (first_index < current_index + capacity) {
-        int gap = first_index - current_index;
-        buffer_data(first_index, data.substr(0, min(data.length(), capacity - gap)));
+        else hold(begin, useful, output.available_capacity());
     }
 
-    if (is_last_substring) hasTouchedLast = true;
-    if (hasTouchedLast && buffered_string_indices.empty()) output.close();
+    close_if_finished(output);
 }
 
-uint64_t Reassembler::bytes_pending() const
+void Reassembler::insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output )
 {
-    // Your code here.
-    return number_of_buffered_bytes;
+    insert(first_index, BufferSlice(move(data)), is_last_substring, output);
 }
 
-void Reassembler::update_buffer(Writer& output) {
-    auto itr_index = buffered_string_indices.begin();
-    auto itr_data = buffered_strings.begin();
-    for (; itr_index != buffered_string_indices.end();) {
-        if (current_index < *itr_index) break;
-        else if (current_index < *itr_index + (*itr_data).length()) {
-            string data = *itr_data;
-
-            int start = current_index - *itr_index;
-            int len = data.length() - start;
-            number_of_buffered_bytes -= (*itr_data).length();
-            output.push(data.substr(start, len));
-            current_index += len;
-
-            itr_index = buffered_string_indices.erase(itr_index);
-            itr_data = buffered_strings.erase(itr_data);
-        }
-        else {
-            number_of_buffered_bytes -= (*itr_data).length();
-            itr_index = buffered_string_indices.erase(itr_index);
-            itr_data = buffered_strings.erase(itr_data);
-        }
+void Reassembler::insert( uint64_t first_index, BufferSlice data, bool is_last_substring, Writer& output )
+{
+    if (is_last_substring) end_index = first_index + data.size();
+
+    auto [begin, end] = useful_range(first_index, data.size(), output);
+    if (begin < end) {
+        BufferSlice useful { move(data.buffer), data.offset + (begin - first_index), end - begin };
+        if (begin == current_index) deliver(useful.view(), output);
+        else hold(begin, useful, output.available_capacity());
     }
+
+    close_if_finished(output);
 }
 
-void Reassembler::buffer_data(long unsigned int first_index, string data) {
-    auto itr_index = buffered_string_indices.begin();
-    auto itr_data = buffered_strings.begin();
-    for (; itr_index != buffered_string_indices.end(); ++itr_index, ++itr_data) {
-        long unsigned int start_index = *itr_index;
-        string current_str = *itr_data;
-        if (first_index < start_index) {
-            itr_index = buffered_string_indices.insert(itr_index, first_index);
-            long unsigned int gap = start_index - first_index;
-            if (data.length() <= gap) {
-                itr_data = buffered_strings.insert(itr_data, data.substr(0, data.length()));
-                number_of_buffered_bytes += data.length();
-                data = "";
-                break;
-            }
-            else {
-                itr_data = buffered_strings.insert(itr_data, data.substr(0, gap));
-                data = data.substr(gap, data.length() - gap);
-                number_of_buffered_bytes += gap;
-                first_index = start_index;
-            }
-        }
-        if (first_index + data.length() <= start_index + current_str.length()) {
-            data = "";
-            break;
-        }
-        if (start_index + current_str.length() > first_index) {
-            long unsigned int gap = start_index + current_str.length() - first_index;
-            data = data.substr(gap, data.length() - gap);
-            first_index += gap;
+void Reassembler::insert_batch( span<Segment> segments, Writer& output )
+{
+    sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.first_index < b.first_index;
+    });
+
+    // split the batch into the run that extends the stream and the segments beyond its first gap
+    uint64_t window = output.available_capacity();
+    uint64_t contiguous = current_index;
+    vector<string_view> prefix;
+    for (Segment& segment : segments) {
+        if (segment.is_last_substring) end_index = segment.first_index + segment.data.size();
+
+        auto [begin, end] = useful_range(segment.first_index, segment.data.size(), output);
+        begin = max(begin, contiguous);
+        if (begin >= end) continue;
+
+        uint64_t offset = begin - segment.first_index;
+        if (begin == contiguous) {
+            prefix.push_back(string_view(segment.data).substr(offset, end - begin));
+            contiguous = end;
         }
+        else if (auto* held = get_if<SegmentMap>(&pending)) held->insert(begin, { segment.data, offset, end - begin });
+        else hold(begin, string_view(segment.data).substr(offset, end - begin), window);
     }
-    if (data.length() != 0) {
-        buffered_string_indices.push_back(first_index);
-        buffered_strings.push_back(data);
-        number_of_buffered_bytes += data.length();
+
+    // one pass of copies into the stream, then one flush of whatever the held bytes now continue
+    if (contiguous > current_index) {
+        for (string_view piece : prefix) write(output, piece);
+        current_index = visit([&](auto& storage) { return storage.flush(contiguous, output); }, pending);
     }
-}
\ No newline at end of file
+
+    close_if_finished(output);
+}
+
+uint64_t Reassembler::bytes_pending() const
+{
+    // Your code here.
+    return visit([](const auto& storage) { return storage.size(); }, pending);
+}
+
+vector<ByteRange> Reassembler::held_ranges( uint64_t max_ranges ) const
+{
+    vector<ByteRange> ranges;
+    visit([&](const auto& storage) { storage.ranges(max_ranges, ranges); }, pending);
+    return ranges;
+}
+
+pair<uint64_t, uint64_t> Reassembler::useful_range( uint64_t first_index, uint64_t len, const Writer& output ) const
+{
+    // only the part of the data inside the window [current_index, current_index + capacity) is useful
+    uint64_t window_end = current_index + output.available_capacity();
+    return { max(first_index, current_index), min(first_index + len, window_end) };
+}
+
+void Reassembler::hold( uint64_t first_index, string_view data, uint64_t window )
+{
+    if (auto* ring = get_if<BitmapRing>(&pending)) ring->insert(first_index, data, window);
+    else if (auto* pooled = get_if<PooledSegments>(&pending)) pooled->insert(first_index, data);
+}
+
+void Reassembler::hold( uint64_t first_index, const BufferSlice& data, uint64_t window )
+{
+    if (auto* segments = get_if<SegmentMap>(&pending)) segments->insert(first_index, data);
+    else hold(first_index, data.view(), window);
+}
+
+void Reassembler::deliver( string_view data, Writer& output )
+{
+    // the next bytes the stream needs: copy them straight into the stream
+    write(output, data);
+    current_index = visit([&](auto& storage) { return storage.flush(current_index + data.size(), output); },
+                          pending);
+}
+
+void Reassembler::close_if_finished( Writer& output ) const
+{
+    if (end_index.has_value() && current_index >= end_index.value()) output.close();
+}
@@ -1,14 +1,33 @@
 #pragma once
 
+#include "bitmap_ring.hh"
 #include "byte_stream.hh"
+#include "reassembler_pool.hh"
+#include "segment_map.hh"
 
+#include <optional>
+#include <span>
 #include <string>
-#include <list>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
 using namespace std;
 
+// How a Reassembler holds the bytes that arrived before the bytes preceding them
+enum class ReassemblerStorage : uint8_t
+{
+    Map,    // an ordered map of non-overlapping segments, sized by what is actually held
+    Bitmap, // one ring covering the stream's window plus a presence bitmap, allocated once
+};
+
 class Reassembler
 {
 public:
+  Reassembler() = default;
+  explicit Reassembler( ReassemblerStorage storage );
+  explicit Reassembler( ReassemblerPool& pool ); // Keep out-of-order bytes in a pool shared with other streams
+
   /*
    * Insert a new substring to be reassembled into a ByteStream.
    *   `first_index`: the index of the first byte of the substring
@@ -31,14 +50,41 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
 
+  // The same, for data that arrived in (a slice of) a shared Buffer. Out-of-order bytes are held as
+  // slices of `data` rather than copies, and are copied only once, into the stream (unless they are a
+  // small part of `data`, which is then copied rather than kept alive whole).
+  void insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output );
+  void insert( uint64_t first_index, BufferSlice data, bool is_last_substring, Writer& output );
+
+  struct Segment
+  {
+    uint64_t first_index {};
+    Buffer data {};
+    bool is_last_substring {};
+  };
+
+  // Insert a burst of segments at once (e.g. everything one recvmmsg() returned). The batch is sorted
+  // in place and walked once: the segments that extend the stream are copied into it back to back,
+  // the rest are held, and the held bytes they unblock are flushed once at the end.
+  void insert_batch( std::span<Segment> segments, Writer& output );
+
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
+
+  // The ranges of stream indices the Reassembler holds beyond the next byte it needs, highest first
+  // and at most `max_ranges` of them (e.g. to advertise as TCP selective acknowledgments). The map
+  // storage visits every segment making up the ranges it returns, so one range pieced together from
+  // N touching segments costs O(N); the bitmap and pooled storages scan their windows a word at a
+  // time, skipping empty words.
+  std::vector<ByteRange> held_ranges( uint64_t max_ranges ) const;
 private:
-    long unsigned int current_index = 0; // index of the byte the reassembler is currently at
-    long unsigned int number_of_buffered_bytes = 0;
-    bool hasTouchedLast = false;
-    list<long unsigned int> buffered_string_indices = list<long unsigned int>();
-    list<string> buffered_strings = list<string>();
-    void update_buffer(Writer& output);
-    void buffer_data(long unsigned first_index, string data);
+    uint64_t current_index = 0; // index of the next byte the stream needs
+    optional<uint64_t> end_index {}; // index just past the last byte of the stream, once known
+    variant<SegmentMap, BitmapRing, PooledSegments> pending {}; // bytes waiting for the gap before them to be filled
+
+    pair<uint64_t, uint64_t> useful_range(uint64_t first_index, uint64_t len, const Writer& output) const;
+    void hold(uint64_t first_index, string_view data, uint64_t window); // Copy into a storage that owns its bytes
+    void hold(uint64_t first_index, const BufferSlice& data, uint64_t window); // Share or copy, as the storage does
+    void deliver(string_view data, Writer& output); // Push bytes starting at current_index, then what they unblock
+    void close_if_finished(Writer& output) const;
 };
@@ -0,0 +1,271 @@
+#include "reassembler_pool.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+
+using namespace std;
+
+static constexpr uint64_t WORD_BITS = 64;
+
+ReassemblerPool::ReassemblerPool( uint64_t budget, EvictionPolicy policy, uint64_t block_size )
+    : budget_( budget ),
+      policy_( policy ),
+      block_size_( max<uint64_t>(WORD_BITS, (block_size + WORD_BITS - 1) / WORD_BITS * WORD_BITS) ),
+      unit_size_( block_size_ + block_size_ / 8 ) {}
+
+ReassemblerPool::Stats ReassemblerPool::stats() const
+{
+    Stats stats { budget_, units_in_use_ * unit_size_, slabs_.size() * BLOCKS_PER_SLAB * unit_size_, 0, evicted_,
+                  streams_.size() };
+    for (const auto& [id, stream] : streams_) stats.pending_bytes += stream.size;
+    return stats;
+}
+
+vector<ReassemblerPool::StreamStats> ReassemblerPool::stream_stats() const
+{
+    vector<StreamStats> ret;
+    ret.reserve(streams_.size());
+    for (const auto& [id, stream] : streams_) ret.push_back({ id, stream.size, stream.blocks.size(), stream.evicted });
+    sort(ret.begin(), ret.end(), [](const auto& a, const auto& b) { return a.id < b.id; });
+    return ret;
+}
+
+ReassemblerPool::StreamId ReassemblerPool::open()
+{
+    streams_.emplace(next_id_, Stream {});
+    return next_id_++;
+}
+
+ReassemblerPool::StreamId ReassemblerPool::clone( StreamId id )
+{
+    StreamId copy_id = open();
+    const Stream& original = streams_.at(id);
+    Stream& copy = streams_.at(copy_id);
+    copy.next = original.next;
+
+    // the copy competes for the budget like any other stream, so it may end up holding less
+    for (const auto& [block, unit] : original.blocks) {
+        char* copy_unit = allocate(copy_id, copy, block);
+        if (copy_unit == nullptr) break;
+        memcpy(copy_unit, unit, unit_size_);
+        copy.size += count(copy_unit);
+    }
+    return copy_id;
+}
+
+void ReassemblerPool::close( StreamId id )
+{
+    auto itr = streams_.find(id);
+    if (itr == streams_.end()) return;
+
+    Stream& stream = itr->second;
+    while (!stream.blocks.empty()) release(stream, stream.blocks.begin());
+    update_key(id, stream);
+    streams_.erase(itr);
+}
+
+void ReassemblerPool::insert( StreamId id, uint64_t first_index, string_view data )
+{
+    Stream& stream = streams_.at(id);
+    uint64_t index = first_index;
+    while (!data.empty()) {
+        uint64_t block = index / block_size_;
+        uint64_t offset = index % block_size_;
+        uint64_t len = min<uint64_t>(data.size(), block_size_ - offset);
+
+        auto itr = stream.blocks.find(block);
+        char* unit = itr != stream.blocks.end() ? itr->second : allocate(id, stream, block);
+        // out of budget: the rest of the data is even further ahead, so it would not fit either
+        if (unit == nullptr) break;
+
+        memcpy(unit + offset, data.data(), len);
+        stream.size += mark(unit, offset, len, true);
+        index += len;
+        data.remove_prefix(len);
+    }
+}
+
+uint64_t ReassemblerPool::flush( StreamId id, uint64_t index, Writer& output )
+{
+    Stream& stream = streams_.at(id);
+
+    // forget whatever was delivered some other way
+    if (index > stream.next) {
+        while (!stream.blocks.empty() && stream.blocks.begin()->first < index / block_size_) {
+            stream.size -= count(stream.blocks.begin()->second);
+            release(stream, stream.blocks.begin());
+        }
+        if (!stream.blocks.empty() && stream.blocks.begin()->first == index / block_size_) {
+            stream.size -= mark(stream.blocks.begin()->second, 0, index % block_size_, false);
+        }
+        stream.next = index;
+    }
+
+    // push the run at the front, block by block, straight from the units into the stream
+    while (!stream.blocks.empty() && stream.blocks.begin()->first == stream.next / block_size_) {
+        auto itr = stream.blocks.begin();
+        uint64_t offset = stream.next % block_size_;
+        uint64_t len = run_length(itr->second, offset);
+        uint64_t written = write(output, string_view(itr->second + offset, len));
+        stream.size -= mark(itr->second, offset, written, false);
+        stream.next += written;
+
+        bool consumed = stream.next % block_size_ == 0 && written > 0;
+        if (consumed || count(itr->second) == 0) release(stream, itr);
+        if (!consumed) break;
+    }
+
+    update_key(id, stream);
+    return stream.next;
+}
+
+uint64_t ReassemblerPool::size( StreamId id ) const
+{
+    return streams_.at(id).size;
+}
+
+void ReassemblerPool::ranges( StreamId id, uint64_t max_ranges, vector<ByteRange>& out ) const
+{
+    const Stream& stream = streams_.at(id);
+    RangeCollector collector(out, max_ranges);
+    for (auto itr = stream.blocks.rbegin(); itr != stream.blocks.rend() && !collector.full(); ++itr) {
+        const uint64_t* bits = present(itr->second);
+        for (uint64_t word = block_size_ / WORD_BITS; word-- > 0 && !collector.full();) {
+            if (bits[word] != 0) collector.feed(itr->first * block_size_ + word * WORD_BITS, bits[word], WORD_BITS);
+        }
+    }
+    collector.finish();
+}
+
+uint64_t ReassemblerPool::key_of( const Stream& stream ) const
+{
+    if (policy_ == EvictionPolicy::LargestStream) return stream.blocks.size();
+    // distance from the next byte the stream needs to the end of its furthest block
+    return (prev(stream.blocks.end())->first + 1) * block_size_ - stream.next;
+}
+
+void ReassemblerPool::update_key( StreamId id, Stream& stream )
+{
+    if (stream.listed) victims_.erase({ stream.key, id });
+    stream.listed = !stream.blocks.empty();
+    if (stream.listed) {
+        stream.key = key_of(stream);
+        victims_.emplace(stream.key, id);
+    }
+}
+
+char* ReassemblerPool::allocate( StreamId id, Stream& stream, uint64_t block )
+{
+    while ((units_in_use_ + 1) * unit_size_ > budget_) {
+        if (victims_.empty()) return nullptr;
+
+        // the new block ranks where it would put its stream; evict only a stream ranked above that
+        uint64_t candidate_key = policy_ == EvictionPolicy::LargestStream
+                                 ? stream.blocks.size() + 1
+                                 : (block + 1) * block_size_ - stream.next;
+        auto [key, victim_id] = *victims_.rbegin();
+        if (key <= candidate_key) return nullptr;
+
+        Stream& victim = streams_.at(victim_id);
+        auto furthest = prev(victim.blocks.end());
+        uint64_t dropped = count(furthest->second);
+        victim.size -= dropped;
+        victim.evicted += dropped;
+        evicted_ += dropped;
+        release(victim, furthest);
+        update_key(victim_id, victim);
+    }
+
+    if (free_units_.empty()) {
+        slabs_.push_back(make_unique<char[]>(BLOCKS_PER_SLAB * unit_size_));
+        for (uint64_t i = BLOCKS_PER_SLAB; i-- > 0;) free_units_.push_back(slabs_.back().get() + i * unit_size_);
+    }
+    char* unit = free_units_.back();
+    free_units_.pop_back();
+    ++units_in_use_;
+
+    memset(present(unit), 0, block_size_ / 8);
+    stream.blocks.emplace(block, unit);
+    update_key(id, stream);
+    return unit;
+}
+
+void ReassemblerPool::release( Stream& stream, map<uint64_t, char*>::iterator block )
+{
+    free_units_.push_back(block->second);
+    --units_in_use_;
+    stream.blocks.erase(block);
+}
+
+uint64_t ReassemblerPool::mark( char* unit, uint64_t offset, uint64_t len, bool is_present ) const
+{
+    uint64_t* bits = present(unit);
+    uint64_t changed = 0;
+    while (len > 0) {
+        uint64_t bit = offset % WORD_BITS;
+        uint64_t n = min(len, WORD_BITS - bit);
+        uint64_t mask = (n == WORD_BITS ? ~uint64_t {0} : (uint64_t {1} << n) - 1) << bit;
+        uint64_t& word = bits[offset / WORD_BITS];
+        uint64_t updated = is_present ? word | mask : word & ~mask;
+        changed += popcount(word ^ updated);
+        word = updated;
+        offset += n;
+        len -= n;
+    }
+    return changed;
+}
+
+uint64_t ReassemblerPool::count( char* unit ) const
+{
+    const uint64_t* bits = present(unit);
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < block_size_ / WORD_BITS; ++i) total += popcount(bits[i]);
+    return total;
+}
+
+uint64_t ReassemblerPool::run_length( char* unit, uint64_t offset ) const
+{
+    const uint64_t* bits = present(unit);
+    uint64_t len = 0;
+    while (offset < block_size_) {
+        uint64_t bit = offset % WORD_BITS;
+        uint64_t ones = countr_one(bits[offset / WORD_BITS] >> bit);
+        len += min(ones, WORD_BITS - bit);
+        if (ones < WORD_BITS - bit) break;
+        offset += WORD_BITS - bit;
+    }
+    return len;
+}
+
+PooledSegments::~PooledSegments()
+{
+    if (pool_ != nullptr) pool_->close(id_);
+}
+
+PooledSegments::PooledSegments( const PooledSegments& other )
+    : pool_( other.pool_ ), id_( other.pool_->clone(other.id_) ) {}
+
+PooledSegments& PooledSegments::operator=( const PooledSegments& other )
+{
+    if (this != &other) {
+        if (pool_ != nullptr) pool_->close(id_);
+        pool_ = other.pool_;
+        id_ = pool_->clone(other.id_);
+    }
+    return *this;
+}
+
+PooledSegments::PooledSegments( PooledSegments&& other ) noexcept
+    : pool_( exchange(other.pool_, nullptr) ), id_( other.id_ ) {}
+
+PooledSegments& PooledSegments::operator=( PooledSegments&& other ) noexcept
+{
+    if (this != &other) {
+        if (pool_ != nullptr) pool_->close(id_);
+        pool_ = exchange(other.pool_, nullptr);
+        id_ = other.id_;
+    }
+    return *this;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "byte_range.hh"
+#include "byte_stream.hh"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Which stream gives up memory when a ReassemblerPool runs out of budget
+enum class EvictionPolicy : uint8_t
+{
+    FurthestAhead, // the stream holding the block furthest ahead of the bytes it is waiting for
+    LargestStream, // the stream holding the most blocks
+};
+
+// Out-of-order storage shared by many Reassemblers (e.g. one per connection) under one memory budget.
+//
+// Each stream's index space is cut into aligned blocks of `block_size` bytes. A block that holds
+// at least one out-of-order byte takes one fixed-size unit of pool memory: the bytes themselves at
+// their offset in the block, followed by a presence bitmap. Units are carved out of slabs of
+// BLOCKS_PER_SLAB units and recycled through a free list, so a stream costs nothing until it
+// reorders, and the pool's memory never exceeds `budget` bytes of units, however many streams there are.
+//
+// When an insert needs a unit beyond the budget, the policy picks the stream with the largest
+// key (distance of its furthest block, or number of blocks), and that stream's furthest-ahead
+// block is dropped. If the inserting stream would itself rank at least as high, the new bytes
+// are dropped instead. Either way a TCP sender will retransmit them.
+class ReassemblerPool
+{
+public:
+    using StreamId = uint64_t;
+
+    struct Stats
+    {
+        uint64_t budget = 0;        // bytes of units the pool may hand out
+        uint64_t memory_in_use = 0; // bytes of units held by streams
+        uint64_t slab_bytes = 0;    // bytes of slabs allocated so far (units in use or on the free list)
+        uint64_t pending_bytes = 0; // out-of-order bytes held, over all streams
+        uint64_t evicted_bytes = 0; // out-of-order bytes dropped to stay within the budget, ever
+        uint64_t streams = 0;
+    };
+
+    struct StreamStats
+    {
+        StreamId id = 0;
+        uint64_t pending_bytes = 0;
+        uint64_t blocks = 0;
+        uint64_t evicted_bytes = 0;
+    };
+
+    explicit ReassemblerPool( uint64_t budget,
+                              EvictionPolicy policy = EvictionPolicy::FurthestAhead,
+                              uint64_t block_size = 2048 );
+
+    Stats stats() const;
+    std::vector<StreamStats> stream_stats() const;
+
+    // Used by PooledSegments, the Reassembler storage backed by a pool
+    StreamId open();
+    StreamId clone( StreamId id );
+    void close( StreamId id );
+    void insert( StreamId id, uint64_t first_index, std::string_view data );
+    uint64_t flush( StreamId id, uint64_t index, Writer& output );
+    uint64_t size( StreamId id ) const;
+    void ranges( StreamId id, uint64_t max_ranges, std::vector<ByteRange>& out ) const;
+
+private:
+    struct Stream
+    {
+        std::map<uint64_t, char*> blocks {}; // block number -> unit
+        uint64_t next = 0;                   // stream index of the first byte that may be held
+        uint64_t size = 0;                   // number of bytes held
+        uint64_t evicted = 0;                // number of bytes dropped by eviction
+        uint64_t key = 0;                    // the stream's entry in victims_, if `listed`
+        bool listed = false;
+    };
+
+    static constexpr uint64_t BLOCKS_PER_SLAB = 64;
+
+    uint64_t budget_;
+    EvictionPolicy policy_;
+    uint64_t block_size_;
+    uint64_t unit_size_; // block_size_ bytes, then one presence bit per byte
+
+    std::vector<std::unique_ptr<char[]>> slabs_ {};
+    std::vector<char*> free_units_ {};
+    uint64_t units_in_use_ = 0;
+    uint64_t evicted_ = 0;
+
+    StreamId next_id_ = 0;
+    std::unordered_map<StreamId, Stream> streams_ {};
+    std::set<std::pair<uint64_t, StreamId>> victims_ {}; // (key, stream) for every stream holding blocks
+
+    uint64_t* present( char* unit ) const { return reinterpret_cast<uint64_t*>( unit + block_size_ ); }
+    uint64_t key_of( const Stream& stream ) const;
+    void update_key( StreamId id, Stream& stream ); // Re-rank the stream after its blocks or `next` changed
+
+    char* allocate( StreamId id, Stream& stream, uint64_t block );
+    void release( Stream& stream, std::map<uint64_t, char*>::iterator block );
+    uint64_t mark( char* unit, uint64_t offset, uint64_t len, bool is_present ) const; // Return bits changed
+    uint64_t count( char* unit ) const;                       // Number of bytes the unit holds
+    uint64_t run_length( char* unit, uint64_t offset ) const; // Bytes held contiguously from `offset`
+};
+
+// A Reassembler storage that keeps its out-of-order bytes in a ReassemblerPool. The pool must
+// outlive every Reassembler that uses it.
+class PooledSegments
+{
+    ReassemblerPool* pool_;
+    ReassemblerPool::StreamId id_;
+
+public:
+    explicit PooledSegments( ReassemblerPool& pool ) : pool_( &pool ), id_( pool.open() ) {}
+    ~PooledSegments();
+
+    PooledSegments( const PooledSegments& other );
+    PooledSegments& operator=( const PooledSegments& other );
+    PooledSegments( PooledSegments&& other ) noexcept;
+    PooledSegments& operator=( PooledSegments&& other ) noexcept;
+
+    // Hold the bytes of `data`, as far as the pool's budget allows
+    void insert( uint64_t first_index, std::string_view data ) { pool_->insert( id_, first_index, data ); }
+    uint64_t flush( uint64_t index, Writer& output ) { return pool_->flush( id_, index, output ); }
+
+    // Append the highest `max_ranges` ranges of held bytes, highest first
+    void ranges( uint64_t max_ranges, std::vector<ByteRange>& out ) const { pool_->ranges( id_, max_ranges, out ); }
+
+    uint64_t size() const { return pool_ ? pool_->size( id_ ) : 0; }
+    ReassemblerPool::StreamId id() const { return id_; }
+};
@@ -0,0 +1,83 @@
+#include "ring_buffer.hh"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+RingBuffer::RingBuffer( uint64_t capacity ) : storage_( capacity, 0 ) {}
+
+uint64_t RingBuffer::tail() const
+{
+    uint64_t tail = head_ + size_;
+    if (tail >= capacity()) tail -= capacity();
+    return tail;
+}
+
+uint64_t RingBuffer::push( string_view data )
+{
+    reserved_ = 0;
+    uint64_t len = min( data.size(), available() );
+    if (len == 0) return 0;
+
+    uint64_t tail = this->tail();
+
+    // the free region may wrap around the end of the storage, so copy it in two pieces
+    uint64_t first = min( len, capacity() - tail );
+    memcpy( storage_.data() + tail, data.data(), first );
+    memcpy( storage_.data(), data.data() + first, len - first );
+
+    size_ += len;
+    return len;
+}
+
+string_view RingBuffer::peek() const
+{
+    return { storage_.data() + head_, min( size_, capacity() - head_ ) };
+}
+
+void RingBuffer::peek_all( vector<string_view>& views ) const
+{
+    string_view first = peek();
+    if (first.empty()) return;
+    views.push_back(first);
+    if (first.size() < size_) views.emplace_back(storage_.data(), size_ - first.size());
+}
+
+void RingBuffer::pop( uint64_t len )
+{
+    reserved_ = 0;
+    len = min( len, size_ );
+    size_ -= len;
+    if (size_ == 0) {
+        // rewind so that the next pushes are peekable in one contiguous piece
+        head_ = 0;
+        return;
+    }
+    head_ += len;
+    if (head_ >= capacity()) head_ -= capacity();
+}
+
+span<char> RingBuffer::reserve( uint64_t len )
+{
+    // the free space right after the tail runs either to the end of the storage or up to the head
+    uint64_t tail = this->tail();
+    reserved_ = min( { len, available(), capacity() - tail } );
+    return { storage_.data() + tail, reserved_ };
+}
+
+void RingBuffer::reserve_all( vector<span<char>>& spans )
+{
+    // the free space is contiguous modulo the capacity, so commit() needs no special case for it
+    span<char> first = reserve(available());
+    if (first.empty()) return;
+    spans.push_back(first);
+    if (first.size() < available()) spans.emplace_back(storage_.data(), available() - first.size());
+    reserved_ = available();
+}
+
+void RingBuffer::commit( uint64_t len )
+{
+    size_ += min( len, reserved_ );
+    reserved_ = 0;
+}
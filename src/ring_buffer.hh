@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A fixed-capacity circular buffer of bytes, used as the storage of a ByteStream.
+// Pushing copies into the free region (in at most two memcpy's), popping just advances
+// the head, so neither operation ever shifts or reallocates the buffered bytes.
+class RingBuffer
+{
+    std::string storage_;
+    uint64_t head_ = 0; // offset in storage_ of the first buffered byte
+    uint64_t size_ = 0; // number of bytes currently buffered
+    uint64_t reserved_ = 0; // length of the space handed out by the last reserve() or reserve_all()
+
+    uint64_t tail() const; // offset in storage_ just past the last buffered byte
+
+public:
+    explicit RingBuffer( uint64_t capacity );
+
+    uint64_t push( std::string_view data ); // Copy as much of `data` as fits, return how many bytes were taken
+    std::string_view peek() const;          // The largest contiguous run of buffered bytes, starting at the head
+    void peek_all( std::vector<std::string_view>& views ) const; // Append every buffered region, in order
+    void pop( uint64_t len );               // Discard up to `len` bytes from the head
+
+    std::span<char> reserve( uint64_t len ); // Up to `len` bytes of contiguous free space right after the tail
+    void reserve_all( std::vector<std::span<char>>& spans ); // Reserve all free space, as one or two spans
+    void commit( uint64_t len );             // Make the first `len` reserved bytes part of the buffer
+
+    uint64_t size() const { return size_; }
+    uint64_t capacity() const { return storage_.size(); }
+    uint64_t available() const { return storage_.size() - size_; }
+};
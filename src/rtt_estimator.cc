@@ -0,0 +1,35 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void RTTEstimator::sample( uint64_t rtt_ms )
+{
+    double r = static_cast<double>(rtt_ms);
+    samples_ += 1;
+    if (!srtt_ms_) {
+        srtt_ms_ = r;
+        rttvar_ms_ = r / 2;
+        return;
+    }
+
+    // RTTVAR first, so it measures how far this sample is from the old SRTT (alpha = 1/8, beta = 1/4)
+    rttvar_ms_ = 0.75 * rttvar_ms_ + 0.25 * abs(*srtt_ms_ - r);
+    srtt_ms_ = 0.875 * *srtt_ms_ + 0.125 * r;
+}
+
+uint64_t RTTEstimator::rto_ms() const
+{
+    if (!srtt_ms_) {
+        return initial_rto_ms_;
+    }
+    double rto = *srtt_ms_ + max(static_cast<double>(CLOCK_GRANULARITY_MS), 4 * rttvar_ms_);
+    return clamp(static_cast<uint64_t>(ceil(rto)), MIN_RTO_MS, MAX_RTO_MS);
+}
+
+uint64_t RTTEstimator::backoff( uint64_t rto_ms )
+{
+    return min(rto_ms * 2, MAX_RTO_MS);
+}
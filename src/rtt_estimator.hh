@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// Where a TCPSender's retransmission timeout comes from
+enum class RTOMode : uint8_t
+{
+    Fixed,      // the initial RTO, reset on every ack and doubled on every timeout (the estimates are still kept)
+    Karn,       // RFC 6298, timing only segments that were sent once (Karn's algorithm)
+    Timestamps, // RFC 6298, timing every ack by the timestamp the receiver echoes (RFC 7323)
+};
+
+// Smoothed round-trip time and its variation, and the retransmission timeout they give (RFC 6298)
+class RTTEstimator
+{
+    std::optional<double> srtt_ms_ {};
+    double rttvar_ms_ = 0;
+    uint64_t initial_rto_ms_;
+    uint64_t samples_ = 0;
+
+public:
+    static constexpr uint64_t CLOCK_GRANULARITY_MS = 1;
+    static constexpr uint64_t MIN_RTO_MS = 200; // Linux's floor; RFC 6298 asks for one second
+    static constexpr uint64_t MAX_RTO_MS = 60'000;
+
+    explicit RTTEstimator( uint64_t initial_rto_ms ) : initial_rto_ms_( initial_rto_ms ) {}
+
+    /* Fold in one measured round trip */
+    void sample( uint64_t rtt_ms );
+
+    /* The RTO before any backoff: the initial one until there is a sample, then SRTT + 4 RTTVAR, clamped */
+    uint64_t rto_ms() const;
+
+    /* The RTO doubled after a timeout, no higher than MAX_RTO_MS */
+    static uint64_t backoff( uint64_t rto_ms );
+
+    std::optional<double> srtt_ms() const { return srtt_ms_; } // empty until the first sample
+    double rttvar_ms() const { return rttvar_ms_; }
+    uint64_t samples() const { return samples_; }
+};
@@ -0,0 +1,69 @@
+#include "segment_map.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+using namespace std;
+
+void SegmentMap::insert( uint64_t first_index, const BufferSlice& data )
+{
+    uint64_t begin = first_index;
+    uint64_t end = first_index + data.length;
+
+    // skip whatever the segment starting at or before `begin` already covers
+    auto itr = segments_.upper_bound(begin);
+    if (itr != segments_.begin()) {
+        auto previous = prev(itr);
+        begin = max(begin, previous->first + previous->second.length);
+    }
+
+    // then store only the gaps between the segments that follow
+    while (begin < end) {
+        uint64_t gap_end = end;
+        if (itr != segments_.end()) gap_end = min(end, itr->first);
+        if (begin < gap_end) {
+            BufferSlice gap { data.buffer, data.offset + (begin - first_index), gap_end - begin };
+            if (gap.length < data.buffer.size() / MAX_SLICE_WASTE) gap = BufferSlice(string(gap.view()));
+            segments_.emplace_hint(itr, begin, move(gap));
+            size_ += gap_end - begin;
+        }
+        if (itr == segments_.end()) break;
+        begin = max(begin, itr->first + itr->second.length);
+        ++itr;
+    }
+}
+
+void SegmentMap::ranges( uint64_t max_ranges, vector<ByteRange>& out ) const
+{
+    // segments never overlap but may touch, in which case they make up one range
+    uint64_t found = 0;
+    for (auto itr = segments_.rbegin(); itr != segments_.rend(); ++itr) {
+        uint64_t end = itr->first + itr->second.length;
+        if (found > 0 && out.back().begin == end) {
+            out.back().begin = itr->first;
+            continue;
+        }
+        if (found == max_ranges) break;
+        out.push_back({ itr->first, end });
+        ++found;
+    }
+}
+
+uint64_t SegmentMap::flush( uint64_t index, Writer& output )
+{
+    while (!segments_.empty()) {
+        auto itr = segments_.begin();
+        if (itr->first > index) break;
+
+        const BufferSlice& segment = itr->second;
+        uint64_t segment_end = itr->first + segment.length;
+        size_ -= segment.length;
+        if (segment_end > index) {
+            write(output, segment.view().substr(index - itr->first));
+            index = segment_end;
+        }
+        segments_.erase(itr);
+    }
+    return index;
+}
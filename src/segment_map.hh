@@ -0,0 +1,33 @@
+#pragma once
+
+#include "buffer.hh"
+#include "byte_range.hh"
+#include "byte_stream.hh"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Reassembler storage that keeps out-of-order bytes as non-overlapping segments keyed by the index
+// of their first byte. An insert only touches the segments around its own range, O(log n) to find
+// them, and stores just the gaps between them. Segments are slices of the Buffers that carried them,
+// so holding bytes (or trimming the overlap off them) doesn't copy them; they are copied once, into
+// the stream, when flushed. The exception is a gap that is a small part of its Buffer: a slice keeps
+// the whole Buffer alive, so that gap is copied into its own, and memory stays bounded by what is held.
+class SegmentMap
+{
+    static constexpr uint64_t MAX_SLICE_WASTE = 4; // copy a gap under 1/MAX_SLICE_WASTE of its Buffer
+
+    std::map<uint64_t, BufferSlice> segments_ {};
+    uint64_t size_ = 0; // number of bytes held
+
+public:
+    void insert( uint64_t first_index, const BufferSlice& data ); // Hold the bytes of `data` not held yet
+    uint64_t flush( uint64_t index, Writer& output ); // Drop bytes before `index`, push the run starting there,
+                                                      // return the index just past what was pushed
+
+    // Append the highest `max_ranges` ranges of held bytes, highest first (one step per segment in them)
+    void ranges( uint64_t max_ranges, std::vector<ByteRange>& out ) const;
+
+    uint64_t size() const { return size_; }
+};
@@ -0,0 +1,160 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+    : capacity_( capacity ), storage_( make_unique<char[]>( capacity ) ) {}
+
+uint64_t SPSCWriter::push( string_view data )
+{
+    if (closed_.load(memory_order_relaxed)) {
+        set_error();
+        return 0;
+    }
+
+    uint64_t pushed = pushed_.load(memory_order_relaxed);
+    if (pushed - popped_cache_ + data.size() > capacity_) {
+        popped_cache_ = popped_.load(memory_order_acquire);
+    }
+    uint64_t len = min(data.size(), capacity_ - (pushed - popped_cache_));
+    if (len == 0) return 0;
+
+    uint64_t tail = pushed % capacity_;
+    uint64_t first = min(len, capacity_ - tail);
+    memcpy(storage_.get() + tail, data.data(), first);
+    memcpy(storage_.get(), data.data() + first, len - first);
+
+    pushed_.store(pushed + len, memory_order_release);
+    data_event_.fetch_add(1, memory_order_release);
+    data_event_.notify_one();
+    return len;
+}
+
+void SPSCWriter::close()
+{
+    closed_.store(true, memory_order_release);
+    data_event_.fetch_add(1, memory_order_release);
+    data_event_.notify_one();
+}
+
+void SPSCWriter::set_error()
+{
+    error_.store(true, memory_order_release);
+    data_event_.fetch_add(1, memory_order_release);
+    data_event_.notify_one();
+    space_event_.fetch_add(1, memory_order_release);
+    space_event_.notify_one();
+}
+
+bool SPSCWriter::is_closed() const
+{
+    return closed_.load(memory_order_relaxed);
+}
+
+uint64_t SPSCWriter::available_capacity() const
+{
+    return capacity_ - (pushed_.load(memory_order_relaxed) - popped_.load(memory_order_acquire));
+}
+
+uint64_t SPSCWriter::bytes_pushed() const
+{
+    return pushed_.load(memory_order_relaxed);
+}
+
+void SPSCWriter::wait_writable( uint64_t len ) const
+{
+    len = min(len, capacity_);
+    while (true) {
+        // read the event counter before checking, so that progress made in between wakes us up
+        uint32_t event = space_event_.load(memory_order_acquire);
+        if (error_.load(memory_order_acquire) || available_capacity() >= len) return;
+        space_event_.wait(event, memory_order_acquire);
+    }
+}
+
+string_view SPSCReader::peek() const
+{
+    uint64_t popped = popped_.load(memory_order_relaxed);
+    uint64_t buffered = pushed_.load(memory_order_acquire) - popped;
+    if (buffered == 0) return {};
+
+    uint64_t head = popped % capacity_;
+    return { storage_.get() + head, min(buffered, capacity_ - head) };
+}
+
+void SPSCReader::pop( uint64_t len )
+{
+    uint64_t popped = popped_.load(memory_order_relaxed);
+    if (popped + len > pushed_cache_) {
+        pushed_cache_ = pushed_.load(memory_order_acquire);
+    }
+    len = min(len, pushed_cache_ - popped);
+    popped_.store(popped + len, memory_order_release);
+    space_event_.fetch_add(1, memory_order_release);
+    space_event_.notify_one();
+}
+
+bool SPSCReader::is_finished() const
+{
+    // closed_ must be read first: once it is set, pushed_ holds its final value
+    return closed_.load(memory_order_acquire)
+           && popped_.load(memory_order_relaxed) == pushed_.load(memory_order_acquire);
+}
+
+bool SPSCReader::has_error() const
+{
+    return error_.load(memory_order_acquire);
+}
+
+uint64_t SPSCReader::bytes_buffered() const
+{
+    return pushed_.load(memory_order_acquire) - popped_.load(memory_order_relaxed);
+}
+
+uint64_t SPSCReader::bytes_popped() const
+{
+    return popped_.load(memory_order_relaxed);
+}
+
+void SPSCReader::wait_readable( uint64_t low_water ) const
+{
+    low_water = min(low_water, capacity_);
+    while (true) {
+        // read the event counter before checking, so that progress made in between wakes us up
+        uint32_t event = data_event_.load(memory_order_acquire);
+        if (closed_.load(memory_order_acquire) || error_.load(memory_order_acquire)
+            || bytes_buffered() >= low_water) {
+            return;
+        }
+        data_event_.wait(event, memory_order_acquire);
+    }
+}
+
+SPSCReader& SPSCByteStream::reader()
+{
+    static_assert( sizeof( SPSCReader ) == sizeof( SPSCByteStream ),
+                   "Please add member variables to the SPSCByteStream base, not the SPSCReader." );
+
+    return static_cast<SPSCReader&>( *this ); // NOLINT(*-downcast)
+}
+
+const SPSCReader& SPSCByteStream::reader() const
+{
+    return static_cast<const SPSCReader&>( *this ); // NOLINT(*-downcast)
+}
+
+SPSCWriter& SPSCByteStream::writer()
+{
+    static_assert( sizeof( SPSCWriter ) == sizeof( SPSCByteStream ),
+                   "Please add member variables to the SPSCByteStream base, not the SPSCWriter." );
+
+    return static_cast<SPSCWriter&>( *this ); // NOLINT(*-downcast)
+}
+
+const SPSCWriter& SPSCByteStream::writer() const
+{
+    return static_cast<const SPSCWriter&>( *this ); // NOLINT(*-downcast)
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class SPSCReader;
+class SPSCWriter;
+
+// A ByteStream that may be written by one thread and read by another without a lock.
+//
+// The bytes live in a ring of `capacity` bytes. The writer owns the cumulative `pushed_` counter and
+// the reader owns `popped_`; each side publishes its counter with a release store and reads the
+// other's with an acquire load, so the bytes between the two are always visible to the reader and
+// free for the writer. The two sides are kept on separate cache lines, and each side caches the
+// other's counter so that it only touches the shared line when it appears to have run out of room.
+//
+// Instead of spinning, either side can block in wait_readable()/wait_writable(). Each side bumps an
+// event counter after making progress and the waiter sleeps on the other side's counter with
+// std::atomic::wait (a futex on Linux), which costs no system call while nobody is waiting.
+class SPSCByteStream
+{
+protected:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // shared, read-only after construction
+    uint64_t capacity_;
+    std::unique_ptr<char[]> storage_;
+
+    // producer side
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> pushed_ {0};
+    std::atomic<bool> closed_ {false};
+    std::atomic<bool> error_ {false};
+    uint64_t popped_cache_ = 0; // writer's last view of popped_
+    std::atomic<uint32_t> data_event_ {0}; // bumped on push, close and error; the reader waits on it
+
+    // consumer side
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> popped_ {0};
+    uint64_t pushed_cache_ = 0; // reader's last view of pushed_
+    std::atomic<uint32_t> space_event_ {0}; // bumped on pop and error; the writer waits on it
+
+public:
+    explicit SPSCByteStream( uint64_t capacity );
+
+    SPSCReader& reader();
+    const SPSCReader& reader() const;
+    SPSCWriter& writer();
+    const SPSCWriter& writer() const;
+};
+
+// To be used only by the producer thread.
+class SPSCWriter : public SPSCByteStream
+{
+public:
+    uint64_t push( std::string_view data ); // Push as much of data as fits, return how many bytes were pushed.
+
+    void close();     // Signal that the stream has reached its ending. Nothing more will be written.
+    void set_error(); // Signal that the stream suffered an error. May be called from either thread.
+
+    bool is_closed() const;              // Has the stream been closed?
+    uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+    uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+    // Block until at least `len` bytes (at most the capacity) can be pushed, or the stream has an error.
+    // Equivalently, until bytes_buffered() has drained to the high-water mark capacity - `len`.
+    void wait_writable( uint64_t len = 1 ) const;
+};
+
+// To be used only by the consumer thread.
+class SPSCReader : public SPSCByteStream
+{
+public:
+    std::string_view peek() const; // Peek at the next contiguous bytes in the buffer
+    void pop( uint64_t len );      // Remove `len` bytes from the buffer
+
+    bool is_finished() const; // Is the stream finished (closed and fully popped)?
+    bool has_error() const;   // Has the stream had an error?
+
+    uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+    uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+    // Block until at least `low_water` bytes (at most the capacity) are buffered,
+    // or the stream is closed or has an error.
+    void wait_readable( uint64_t low_water = 1 ) const;
+};
@@ -5,11 +5,18 @@ using namespace std;
 void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream )
 {
     if (message.SYN) {
-        reassembler.insert(0, message.payload, message.FIN, inbound_stream);
+        if (message.timestamp.has_value()) ts_recent = message.timestamp;
+        reassembler.insert(0, move(message.payload), message.FIN, inbound_stream);
         zero_point = message.seqno;
     }
     else if (zero_point.has_value()){
-        reassembler.insert(message.seqno.unwrap(zero_point.value(), 0) - 1, message.payload, message.FIN, inbound_stream);
+        // unwrap near the next byte the stream needs, so that streams longer than 4 GiB map to the right index
+        uint64_t checkpoint = inbound_stream.bytes_pushed() + 1;
+        uint64_t first_index = message.seqno.unwrap(zero_point.value(), checkpoint) - 1;
+
+        // an out-of-order segment's timestamp isn't echoed, so the sender's RTT sample covers the wait for the hole
+        if (message.timestamp.has_value() && first_index <= inbound_stream.bytes_pushed()) ts_recent = message.timestamp;
+        reassembler.insert(first_index, move(message.payload), message.FIN, inbound_stream);
     }
 }
 
@@ -25,5 +32,19 @@ TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
         if (inbound_stream.is_closed()) message.ackno = message.ackno.value() + 1;
     }
     else message.ackno = nullopt;
+    message.timestamp_echo = ts_recent;
+    return message;
+}
+
+TCPReceiverMessage TCPReceiver::send( const Reassembler& reassembler, const Writer& inbound_stream ) const
+{
+    TCPReceiverMessage message = send(inbound_stream);
+    if (zero_point.has_value()) {
+        for (const ByteRange& range : reassembler.held_ranges(TCPReceiverMessage::MAX_SACK_BLOCKS)) {
+            // stream index i has sequence number zero_point + 1 + i, since the SYN comes first
+            message.sack.emplace_back(Wrap32::wrap(range.begin + 1, zero_point.value()),
+                                      Wrap32::wrap(range.end + 1, zero_point.value()));
+        }
+    }
     return message;
 }
@@ -8,7 +8,7 @@
 class TCPReceiver
 {
 public:
-    TCPReceiver(): zero_point(std::nullopt) {}
+    TCPReceiver(): zero_point(std::nullopt), ts_recent(std::nullopt) {}
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
    * at the correct stream index.
@@ -17,6 +17,10 @@ public:
 
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
+
+  /* The same, plus SACK blocks for the out-of-order bytes the Reassembler holds. */
+  TCPReceiverMessage send( const Reassembler& reassembler, const Writer& inbound_stream ) const;
 private:
     optional<Wrap32> zero_point;
+    optional<uint32_t> ts_recent; // timestamp of the latest in-order segment, echoed in every ack
 };
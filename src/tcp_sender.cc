@@ -1,6 +1,5 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
-#include <functional>
 #include <algorithm>
 
 #include <random>
@@ -8,21 +7,22 @@
 using namespace std;
 
 /* TCPSender constructor (uses a random ISN if none given) */
-TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn ):
+TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn, CongestionControl congestion_control,
+                      RTOMode rto_mode, bool fast_retransmit ):
     isn_( fixed_isn.value_or( Wrap32 { random_device()() } ) ), left_edge_of_window(0), right_edge_of_window(1),
     initial_RTO_ms_( initial_RTO_ms ), current_RTO_ms(initial_RTO_ms), timer(0), isTimerOn(false),
-    num_of_consecutive_retransmissions(0), toBeSentSegments(vector<TCPSenderMessage>()),
-    outstandingSegments(vector<TCPSenderMessage>()), SYN(true), FIN(false)
+    num_of_consecutive_retransmissions(0), num_of_seqnos_in_flight(0), num_of_bytes_held(0),
+    clock_ms(0), outstandingSegments(),
+    nextToSend(0), retransmissions(), SYN(true), FIN(false),
+    congestion(make_congestion_controller(congestion_control)), rtoMode(rto_mode), rtt(initial_RTO_ms),
+    fastRetransmit(fast_retransmit), last_ackno(0), last_window_size(0), num_of_dup_acks(0), num_of_seqnos_sacked(0),
+    num_of_segments_sacked(0), recoveryPoint()
 {
 }
 
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
-    uint64_t res = 0;
-    for (auto segment: outstandingSegments) {
-        res += segment.sequence_length();
-    }
-    return res;
+    return num_of_seqnos_in_flight;
 }
 
 uint64_t TCPSender::consecutive_retransmissions() const
@@ -30,7 +30,42 @@ uint64_t TCPSender::consecutive_retransmissions() const
     return num_of_consecutive_retransmissions;
 }
 
-void TCPSender::handleLookAheadCase(const std::string& data, Reader& outbound_stream) {
+uint64_t TCPSender::congestion_window() const
+{
+    return visit([](const auto& algorithm) { return algorithm.window(); }, congestion);
+}
+
+const RTTEstimator& TCPSender::rtt_estimate() const
+{
+    return rtt;
+}
+
+uint64_t TCPSender::retransmission_timeout() const
+{
+    return current_RTO_ms;
+}
+
+bool TCPSender::in_recovery() const
+{
+    return recoveryPoint.has_value();
+}
+
+uint64_t TCPSender::seqnosInPipe() const
+{
+    // SACKed segments have left the network; without SACK, each duplicate ack says one more has (RFC 3042)
+    uint64_t left = num_of_seqnos_sacked;
+    if (num_of_segments_sacked == 0) {
+        left = min(num_of_dup_acks * TCPConfig::MAX_PAYLOAD_SIZE, num_of_seqnos_in_flight);
+    }
+    return num_of_seqnos_in_flight - left;
+}
+
+uint64_t TCPSender::absoluteSeqno(const OutstandingSegment& segment) const
+{
+    return segment.message.seqno.unwrap(isn_, left_edge_of_window);
+}
+
+void TCPSender::handleLookAheadCase(uint64_t numOfNewBytes, Reader& outbound_stream) {
     TCPSenderMessage segment;
     // set seqno field of TCPSenderMessage
     segment.seqno = Wrap32::wrap(left_edge_of_window, isn_);
@@ -38,18 +73,18 @@ void TCPSender::handleLookAheadCase(const std::string& data, Reader& outbound_st
         segment.SYN = true;
         SYN = false;
     }
-    else if (!data.empty()) {
-        segment.payload = data.substr(0, 1);
+    else if (numOfNewBytes > 0) {
+        segment.payload = outbound_stream.peek_slice(num_of_bytes_held, 1);
+        num_of_bytes_held += 1;
     }
     else {
         segment.FIN = true;
         FIN = true;
     }
 
-    outstandingSegments.push_back(segment);
-    toBeSentSegments.push_back(segment);
+    num_of_seqnos_in_flight += segment.sequence_length();
+    outstandingSegments.push_back({move(segment), 0, false, false});
     left_edge_of_window += 1;
-    outbound_stream.pop(1);
 }
 
 void TCPSender::push( Reader& outbound_stream )
@@ -59,8 +94,10 @@ void TCPSender::push( Reader& outbound_stream )
         return;
     }
 
-    // no data in the reader
-    if (!SYN && outbound_stream.bytes_buffered() == 0 && !outbound_stream.is_finished()) {
+    // no data in the reader beyond what is already in segments
+    uint64_t numOfNewBytes = outbound_stream.bytes_buffered() - num_of_bytes_held;
+    bool isClosed = outbound_stream.writer().is_closed();
+    if (!SYN && numOfNewBytes == 0 && !isClosed) {
         return;
     }
 
@@ -75,9 +112,8 @@ void TCPSender::push( Reader& outbound_stream )
     }
 
     // no window but has data, and all previous segment being ack-ed => send 1-byte look-ahead
-    string data = {outbound_stream.peek().begin(), outbound_stream.peek().end()};
     if (left_edge_of_window == right_edge_of_window && outstandingSegments.empty()) {
-        handleLookAheadCase(data, outbound_stream);
+        handleLookAheadCase(numOfNewBytes, outbound_stream);
         return;
     }
 
@@ -85,12 +121,28 @@ void TCPSender::push( Reader& outbound_stream )
 
     // get if we need to set SYN & FIN, and # bytes in the payload
     uint64_t windowSpace = right_edge_of_window - left_edge_of_window;
+
+    // the congestion window bounds everything still in the network, not just what this push() adds
+    uint64_t congestionWindow = congestion_window();
+    uint64_t pipe = seqnosInPipe();
+    if (congestionWindow <= pipe) {
+        return;
+    }
+    uint64_t congestionSpace = congestionWindow - pipe;
+    if (congestionSpace < windowSpace && congestionSpace < numOfNewBytes) {
+        // only whole segments, so a window that grows by a few bytes per ack doesn't chop the stream up
+        // into tiny segments (the sender's half of silly window avoidance, RFC 1122 4.2.3.4)
+        congestionSpace -= congestionSpace % TCPConfig::MAX_PAYLOAD_SIZE;
+        if (congestionSpace == 0) {
+            return;
+        }
+    }
+    windowSpace = min(windowSpace, congestionSpace);
     if (SYN) {
         windowSpace -= 1;
     }
-    uint64_t dataLength = min(outbound_stream.bytes_buffered(), windowSpace);
-    outbound_stream.pop(dataLength);
-    if (outbound_stream.is_finished() && dataLength < windowSpace) {
+    uint64_t dataLength = min(numOfNewBytes, windowSpace);
+    if (isClosed && dataLength == numOfNewBytes && dataLength < windowSpace) {
         FIN = true;
     }
 
@@ -117,35 +169,51 @@ void TCPSender::push( Reader& outbound_stream )
         if (i == numOfSegments && dataLength % TCPConfig::MAX_PAYLOAD_SIZE != 0) {
             numOfBytes = dataLength % TCPConfig::MAX_PAYLOAD_SIZE;
         }
-        segment.payload = data.substr(i * TCPConfig::MAX_PAYLOAD_SIZE, numOfBytes);
+        segment.payload = outbound_stream.peek_slice(num_of_bytes_held, numOfBytes);
+        num_of_bytes_held += segment.payload.size();
 
         // set FIN field of TCPSenderMessage
         if (i == numOfSegments && FIN) {
             segment.FIN = true;
         }
 
-        // put the segment in the buffer
-        outstandingSegments.push_back(segment);
-        toBeSentSegments.push_back(segment);
-
         // update left edge of window
         left_edge_of_window += segment.sequence_length();
+
+        // put the segment in the buffer, where maybe_send() will find it at nextToSend
+        num_of_seqnos_in_flight += segment.sequence_length();
+        outstandingSegments.push_back({move(segment), 0, false, false});
     }
 }
 
 optional<TCPSenderMessage> TCPSender::maybe_send()
 {
-    if (toBeSentSegments.empty()) return nullopt;
+    if (retransmissions.empty() && nextToSend == outstandingSegments.size()) return nullopt;
     if (!isTimerOn) {
         isTimerOn = true;
         timer = 0;
     }
-    TCPSenderMessage res = toBeSentSegments[0];
-    toBeSentSegments.erase(toBeSentSegments.begin());
+    TCPSenderMessage res;
+    if (!retransmissions.empty()) {
+        // segments are in sequence order, and receive() has dropped every queued seqno that was acked
+        uint64_t seqno = retransmissions.front();
+        retransmissions.pop_front();
+        auto segment = partition_point(outstandingSegments.begin(), outstandingSegments.end(),
+            [&](const OutstandingSegment& outstanding) { return absoluteSeqno(outstanding) < seqno; });
+        res = segment->message;
+    }
+    else {
+        OutstandingSegment& next = outstandingSegments[nextToSend++];
+        next.sent_at_ms = clock_ms;
+        res = next.message;
+    }
+    if (rtoMode == RTOMode::Timestamps) {
+        res.timestamp = static_cast<uint32_t>(clock_ms);
+    }
     return res;
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+void TCPSender::receive( const TCPReceiverMessage& msg, Reader& outbound_stream )
 {
     uint64_t ackno = 0;
     if (msg.ackno.has_value()) {
@@ -154,34 +222,168 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
     if (ackno > left_edge_of_window) return;
     uint16_t window = msg.window_size;
     right_edge_of_window = max(right_edge_of_window, ackno + (uint64_t)window);
-    UpdateOutstandingSegmentsFunctor functor(*this, ackno);
-
-    // this variable is set to check if any outstanding segments have been acked
-    long unsigned int previous_num_of_outstanding_segments = outstandingSegments.size();
-    // remove all segments whose seqno are less than the receiver message one, which means, having been acked
-    outstandingSegments.erase(remove_if(outstandingSegments.begin(), outstandingSegments.end(), ref(functor)),
-                              outstandingSegments.end());
-    if (outstandingSegments.size() < previous_num_of_outstanding_segments) {
-        current_RTO_ms = initial_RTO_ms_;
+
+    // remove all segments whose seqno are less than the receiver message one, which means, having been acked.
+    // The segments are in sequence order, so those are all at the front.
+    bool anySegmentAcked = false;
+    uint64_t numOfSeqnosAcked = num_of_seqnos_in_flight;
+    uint64_t numOfBytesAcked = 0;
+    optional<uint64_t> rtt_ms;
+    while (!outstandingSegments.empty()) {
+        const OutstandingSegment& acked = outstandingSegments.front();
+        if (absoluteSeqno(acked) + acked.message.sequence_length() > ackno) break;
+
+        // Karn's rule: only a segment sent exactly once tells how long the round trip took
+        if (nextToSend > 0 && !acked.retransmitted) {
+            rtt_ms = clock_ms - acked.sent_at_ms;
+        }
+        if (acked.sacked) {
+            num_of_seqnos_sacked -= acked.message.sequence_length();
+            num_of_segments_sacked -= 1;
+        }
+        num_of_seqnos_in_flight -= acked.message.sequence_length();
+        numOfBytesAcked += acked.message.payload.size();
+        outstandingSegments.pop_front();
+        if (nextToSend > 0) nextToSend -= 1;
+        anySegmentAcked = true;
+    }
+
+    // segment payloads are slices of the stream's bytes, so those leave the stream only once acked
+    outbound_stream.pop(numOfBytesAcked);
+    num_of_bytes_held -= numOfBytesAcked;
+    if (anySegmentAcked) {
+        // a retransmission queued for a segment that has since been acked has nothing left to resend
+        uint64_t firstOutstanding = outstandingSegments.empty()
+            ? left_edge_of_window : absoluteSeqno(outstandingSegments.front());
+        erase_if(retransmissions, [&](uint64_t seqno) { return seqno < firstOutstanding; });
+    }
+    if (anySegmentAcked) {
+        // an echoed timestamp times whichever transmission the ack answers, retransmissions included
+        if (rtoMode == RTOMode::Timestamps && msg.timestamp_echo.has_value()) {
+            rtt_ms = static_cast<uint32_t>(static_cast<uint32_t>(clock_ms) - msg.timestamp_echo.value());
+        }
+        if (rtt_ms) {
+            rtt.sample(*rtt_ms);
+        }
+
+        // the recovery is over once everything sent before the loss was found has been acked
+        bool wasInRecovery = recoveryPoint.has_value();
+        if (recoveryPoint && ackno >= *recoveryPoint) {
+            recoveryPoint.reset();
+        }
+
+        numOfSeqnosAcked -= num_of_seqnos_in_flight;
+        visit([&](auto& algorithm) {
+            algorithm.on_ack({numOfSeqnosAcked, num_of_seqnos_in_flight, clock_ms, rtt_ms, wasInRecovery});
+        }, congestion);
+
+        // Karn's algorithm: a backed-off RTO stays until an ack gives a sample to replace it
+        if (rtoMode == RTOMode::Fixed) current_RTO_ms = initial_RTO_ms_;
+        else if (rtt_ms) current_RTO_ms = rtt.rto_ms();
         timer = 0;
         num_of_consecutive_retransmissions = 0;
         if (outstandingSegments.empty()) {
             isTimerOn = false;
         }
     }
+
+    if (!fastRetransmit) {
+        return;
+    }
+
+    // a duplicate ack repeats the last one while data is outstanding; a window update isn't one (RFC 5681)
+    bool isDuplicate = !anySegmentAcked && msg.ackno.has_value() && ackno == last_ackno
+                       && window == last_window_size && nextToSend > 0;
+    num_of_dup_acks = isDuplicate ? num_of_dup_acks + 1 : 0;
+    last_ackno = ackno;
+    last_window_size = window;
+    if (outstandingSegments.empty()) {
+        return;
+    }
+
+    markSacked(msg.sack);
+    if (recoveryPoint && anySegmentAcked) {
+        // a partial ack: the segment after the acked ones was lost too (RFC 6582)
+        OutstandingSegment& front = outstandingSegments.front();
+        if (!front.retransmitted && !front.sacked && nextToSend > 0) queueRetransmission(front);
+    }
+    else if (!recoveryPoint && num_of_dup_acks >= TCPConfig::DUP_ACK_THRESHOLD) {
+        recoveryPoint = left_edge_of_window;
+        visit([&](auto& algorithm) { algorithm.on_loss(num_of_seqnos_in_flight, clock_ms); }, congestion);
+        queueRetransmission(outstandingSegments.front());
+    }
+    retransmitLostSegments();
+}
+
+void TCPSender::markSacked(const vector<pair<Wrap32, Wrap32>>& blocks)
+{
+    for (const auto& [left, right] : blocks) {
+        uint64_t begin = left.unwrap(isn_, left_edge_of_window);
+        uint64_t end = right.unwrap(isn_, left_edge_of_window);
+        for (size_t i = 0; i < nextToSend; ++i) {
+            OutstandingSegment& segment = outstandingSegments[i];
+            uint64_t seqno = segment.message.seqno.unwrap(isn_, left_edge_of_window);
+            if (seqno >= end) break;
+            if (!segment.sacked && seqno >= begin && seqno + segment.message.sequence_length() <= end) {
+                segment.sacked = true;
+                num_of_seqnos_sacked += segment.message.sequence_length();
+                num_of_segments_sacked += 1;
+            }
+        }
+    }
+}
+
+void TCPSender::retransmitLostSegments()
+{
+    // a segment is lost once DUP_ACK_THRESHOLD segments sent after it have been SACKed (RFC 6675)
+    if (num_of_segments_sacked < TCPConfig::DUP_ACK_THRESHOLD) return;
+    uint64_t sackedAbove = num_of_segments_sacked;
+    for (size_t i = 0; i < nextToSend && sackedAbove >= TCPConfig::DUP_ACK_THRESHOLD; ++i) {
+        OutstandingSegment& segment = outstandingSegments[i];
+        if (segment.sacked) {
+            sackedAbove -= 1;
+            continue;
+        }
+        if (segment.retransmitted) continue;
+        if (!recoveryPoint) {
+            recoveryPoint = left_edge_of_window;
+            visit([&](auto& algorithm) { algorithm.on_loss(num_of_seqnos_in_flight, clock_ms); }, congestion);
+        }
+        queueRetransmission(segment);
+    }
+}
+
+void TCPSender::queueRetransmission(OutstandingSegment& segment)
+{
+    // the queue never holds a seqno twice, so one loss is never repaired twice
+    segment.retransmitted = true;
+    uint64_t seqno = absoluteSeqno(segment);
+    if (find(retransmissions.begin(), retransmissions.end(), seqno) == retransmissions.end()) {
+        retransmissions.push_back(seqno);
+    }
 }
 
 void TCPSender::tick( const size_t ms_since_last_tick )
 {
-    if (!isTimerOn) return;
+    clock_ms += ms_since_last_tick;
+    // with nothing outstanding there is nothing to time out, whatever state the timer was left in
+    if (!isTimerOn || outstandingSegments.empty()) return;
     timer += ms_since_last_tick;
     if (timer >= current_RTO_ms) {
+        // a timeout with the window open means a loss; a zero-window probe going unanswered does not
         if (left_edge_of_window <= right_edge_of_window) {
-            current_RTO_ms *= 2;
+            current_RTO_ms = rtoMode == RTOMode::Fixed ? current_RTO_ms * 2 : RTTEstimator::backoff(current_RTO_ms);
             num_of_consecutive_retransmissions += 1;
+            visit([&](auto& algorithm) { algorithm.on_timeout(num_of_seqnos_in_flight, clock_ms); }, congestion);
+            recoveryPoint.reset();
+            num_of_dup_acks = 0;
         }
-        TCPSenderMessage segment = outstandingSegments[0];
-        toBeSentSegments.insert(toBeSentSegments.begin(), segment);
+        // the oldest segment goes first, even if a fast retransmit had already queued it further back
+        OutstandingSegment& oldest = outstandingSegments.front();
+        oldest.retransmitted = true;
+        uint64_t seqno = absoluteSeqno(oldest);
+        erase(retransmissions, seqno);
+        retransmissions.push_front(seqno);
         timer = 0;
     }
 }
@@ -192,18 +394,3 @@ TCPSenderMessage TCPSender::send_empty_message() const
     segment.seqno = Wrap32::wrap(left_edge_of_window, isn_);
     return segment;
 }
-
-TCPSender::UpdateOutstandingSegmentsFunctor::UpdateOutstandingSegmentsFunctor(TCPSender &sender, const uint64_t &ackno): sender_(sender), ackno_(ackno)
-{
-}
-
-bool TCPSender::UpdateOutstandingSegmentsFunctor::operator()(const TCPSenderMessage& segment) {
-    uint64_t current_outstanding_seqno = segment.seqno.unwrap(sender_.isn_, sender_.left_edge_of_window)
-                                         + segment.sequence_length();
-
-    if (current_outstanding_seqno > ackno_) {
-        return false;
-    }
-
-    return true;
-}
\ No newline at end of file
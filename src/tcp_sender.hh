@@ -1,7 +1,10 @@
 #pragma once
 
+#include <deque>
 #include <string>
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "rtt_estimator.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
@@ -15,23 +18,46 @@ class TCPSender
     uint64_t timer;
     bool isTimerOn;
     uint8_t num_of_consecutive_retransmissions;
-    std::vector<TCPSenderMessage> toBeSentSegments;
-    std::vector<TCPSenderMessage> outstandingSegments;
+    uint64_t num_of_seqnos_in_flight; // sum of the sequence lengths of outstandingSegments
+    uint64_t num_of_bytes_held; // bytes at the front of the outbound stream that are already in segments
+    uint64_t clock_ms; // sum of every tick(), for timing round trips
+    struct OutstandingSegment {
+        TCPSenderMessage message;
+        uint64_t sent_at_ms; // clock_ms when first sent
+        bool retransmitted;  // its ack can't be told apart from a retransmission's, so gives no RTT sample
+        bool sacked;         // the receiver reported holding it, so it needn't be retransmitted
+    };
+    std::deque<OutstandingSegment> outstandingSegments; // every segment not fully acked yet, in sequence order
+    size_t nextToSend; // index in outstandingSegments of the first segment never sent
+    // absolute seqnos of outstandingSegments to resend, queued by tick() and receive() and sent ahead of any new
+    // segment; receive() drops those that get acked first
+    std::deque<uint64_t> retransmissions;
     bool SYN;
     bool FIN;
-    void handleLookAheadCase(const std::string& data, Reader& outbound_stream);
-    class UpdateOutstandingSegmentsFunctor {
-        TCPSender& sender_;
-        const uint64_t& ackno_; // this is the seqno from the tcp receiver message
-    public:
-        explicit UpdateOutstandingSegmentsFunctor(TCPSender& sender, const uint64_t& ackno);
-        bool operator()(const TCPSenderMessage& segment);
-    };
+    CongestionController congestion;
+    RTOMode rtoMode;
+    RTTEstimator rtt;
+    bool fastRetransmit; // repair losses found by duplicate acks or SACK without waiting for the RTO
+    uint64_t last_ackno;
+    uint16_t last_window_size;
+    uint64_t num_of_dup_acks; // acks in a row that repeated last_ackno and last_window_size, with data outstanding
+    uint64_t num_of_seqnos_sacked; // sum of the sequence lengths of the sacked outstandingSegments
+    uint64_t num_of_segments_sacked;
+    std::optional<uint64_t> recoveryPoint; // while repairing a loss: the next seqno when the loss was found
+    void handleLookAheadCase(uint64_t numOfNewBytes, Reader& outbound_stream);
+    void markSacked(const std::vector<std::pair<Wrap32, Wrap32>>& blocks);
+    void retransmitLostSegments();
+    void queueRetransmission(OutstandingSegment& segment);
+    uint64_t seqnosInPipe() const;
+    uint64_t absoluteSeqno(const OutstandingSegment& segment) const;
 public:
-    /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-    TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
+    /* Construct TCP sender with given default Retransmission Timeout, possible ISN, congestion control,
+       way of adapting the Retransmission Timeout, and whether to fast-retransmit */
+    TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn,
+               CongestionControl congestion_control = CongestionControl::None, RTOMode rto_mode = RTOMode::Fixed,
+               bool fast_retransmit = false );
 
-    /* Push bytes from the outbound stream */
+    /* Push bytes from the outbound stream (they stay in it, as segment payloads, until acked) */
     void push( Reader& outbound_stream );
 
     /* Send a TCPSenderMessage if needed (or empty optional otherwise) */
@@ -40,8 +66,9 @@ public:
     /* Generate an empty TCPSenderMessage */
     TCPSenderMessage send_empty_message() const;
 
-    /* Receive an act on a TCPReceiverMessage from the peer's receiver */
-    void receive( const TCPReceiverMessage& msg );
+    /* Receive an act on a TCPReceiverMessage from the peer's receiver, popping newly acked bytes from the
+       outbound stream (the same stream given to push()) */
+    void receive( const TCPReceiverMessage& msg, Reader& outbound_stream );
 
     /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
     void tick( uint64_t ms_since_last_tick );
@@ -49,4 +76,8 @@ public:
     /* Accessors for use in testing */
     uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
     uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+    uint64_t congestion_window() const;           // How many sequence numbers may be outstanding at once?
+    const RTTEstimator& rtt_estimate() const;     // What are the path's smoothed RTT, RTT variation and RTO?
+    uint64_t retransmission_timeout() const;      // How long does the timer run now, backoff included?
+    bool in_recovery() const;                     // Is a loss found without a timeout still being repaired?
 };
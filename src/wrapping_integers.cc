@@ -1,37 +1,92 @@
 #include "wrapping_integers.hh"
-#include <math.h>
-#include <stdint.h>
+
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WRAP32_HAVE_X86 1
+#endif
 
 using namespace std;
 
-Wrap32 Wrap32::wrap( uint64_t n, Wrap32 zero_point )
+// unwrap_batch loads the seqnos straight out of the span as 32-bit lanes
+static_assert( sizeof( Wrap32 ) == sizeof( uint32_t ) );
+
+namespace {
+
+// The vector kernels compute the same thing as Wrap32::unwrap, one 64-bit lane per seqno:
+//   ahead = (raw - zero_point - checkpoint) mod 2^32
+//   result = checkpoint + ahead, minus 2^32 if ahead > 2^31 and that doesn't go below zero.
+// `shift` is (zero_point + checkpoint) mod 2^32, and `low` says whether checkpoint < 2^32, the only
+// case where going back could go below zero. When it is, checkpoint + ahead < 2^33, so the
+// signed 64-bit comparisons are exact.
+
+#ifdef WRAP32_HAVE_X86
+__attribute__((target("avx2"))) inline __m256i finish_avx2( __m256i ahead, uint64_t checkpoint, bool low )
 {
-    // (a + b) % c = (a % c + b % c) % c
-    return Wrap32((uint32_t)n + zero_point.raw_value_);
+    const __m256i sum = _mm256_add_epi64(ahead, _mm256_set1_epi64x(static_cast<int64_t>(checkpoint)));
+    __m256i back = _mm256_cmpgt_epi64(ahead, _mm256_set1_epi64x(int64_t {1} << 31));
+    if (low) back = _mm256_and_si256(back, _mm256_cmpgt_epi64(sum, _mm256_set1_epi64x(UINT32_MAX)));
+    return _mm256_sub_epi64(sum, _mm256_and_si256(back, _mm256_set1_epi64x(int64_t {1} << 32)));
 }
 
-uint64_t Wrap32::unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+// Unwrap the first n - n % 8 seqnos, and return how many that was
+__attribute__((target("avx2"))) size_t unwrap_avx2( const uint32_t* raw, size_t n, uint32_t shift, uint64_t checkpoint, bool low, uint64_t* out )
 {
-    uint64_t offset = (uint64_t)(this->raw_value_ - zero_point.raw_value_);
-    uint64_t times = checkpoint / (uint64_t)pow(2, 32);
-    uint64_t base = (uint64_t)UINT32_MAX + 1;
-    uint64_t gap1 = base, gap2 = 0, gap3 = 0;
-    if (times > 0) gap1 = get_gap_to_checkpoint(times - 1, checkpoint, offset);
-    gap2 = get_gap_to_checkpoint(times, checkpoint, offset);
-    gap3 = get_gap_to_checkpoint(times + 1, checkpoint, offset);
-
-    if (gap1 < gap2) {
-        if (gap1 < gap3) return (times - 1) * base + offset;
-        else return (times + 1) * base + offset;
+    const __m256i shift_v = _mm256_set1_epi32(static_cast<int32_t>(shift));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i ahead = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw + i)), shift_v);
+        const __m256i lo = finish_avx2(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(ahead)), checkpoint, low);
+        const __m256i hi = finish_avx2(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(ahead, 1)), checkpoint, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4), hi);
     }
-    else {
-        if (gap2 < gap3) return times * base + offset;
-        else return (times + 1) * base + offset;
+    return i;
+}
+
+__attribute__((target("sse4.2"))) inline __m128i finish_sse42( __m128i ahead, uint64_t checkpoint, bool low )
+{
+    const __m128i sum = _mm_add_epi64(ahead, _mm_set1_epi64x(static_cast<int64_t>(checkpoint)));
+    __m128i back = _mm_cmpgt_epi64(ahead, _mm_set1_epi64x(int64_t {1} << 31));
+    if (low) back = _mm_and_si128(back, _mm_cmpgt_epi64(sum, _mm_set1_epi64x(UINT32_MAX)));
+    return _mm_sub_epi64(sum, _mm_and_si128(back, _mm_set1_epi64x(int64_t {1} << 32)));
+}
+
+// Unwrap the first n - n % 4 seqnos, and return how many that was
+__attribute__((target("sse4.2"))) size_t unwrap_sse42( const uint32_t* raw, size_t n, uint32_t shift, uint64_t checkpoint, bool low, uint64_t* out )
+{
+    const __m128i shift_v = _mm_set1_epi32(static_cast<int32_t>(shift));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i ahead = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i)), shift_v);
+        const __m128i lo = finish_sse42(_mm_cvtepu32_epi64(ahead), checkpoint, low);
+        const __m128i hi = finish_sse42(_mm_cvtepu32_epi64(_mm_srli_si128(ahead, 8)), checkpoint, low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 2), hi);
     }
+    return i;
 }
+#endif
+
+} // namespace
+
+void Wrap32::unwrap_batch( span<const Wrap32> seqnos, Wrap32 zero_point, uint64_t checkpoint, span<uint64_t> out )
+{
+    if (out.size() < seqnos.size()) throw runtime_error("Wrap32::unwrap_batch: output shorter than input");
+
+    size_t done = 0;
+#ifdef WRAP32_HAVE_X86
+    const auto* raw = reinterpret_cast<const uint32_t*>(seqnos.data());
+    const uint32_t shift = zero_point.raw_value_ + static_cast<uint32_t>(checkpoint);
+    const bool low = checkpoint <= UINT32_MAX;
+    if (__builtin_cpu_supports("avx2")) {
+        done = unwrap_avx2(raw, seqnos.size(), shift, checkpoint, low, out.data());
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        done = unwrap_sse42(raw, seqnos.size(), shift, checkpoint, low, out.data());
+    }
+#endif
 
-uint64_t get_gap_to_checkpoint(uint64_t times, uint64_t checkpoint, uint64_t offset) {
-    uint64_t absolute = times * (uint64_t)pow(2, 32) + offset;
-    if (absolute > checkpoint) return absolute - checkpoint;
-    else return checkpoint - absolute;
+    // the scalar fallback, and the tail that doesn't fill a vector
+    for (size_t i = done; i < seqnos.size(); i++) out[i] = seqnos[i].unwrap(zero_point, checkpoint);
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <cstdint>
-#include <math.h>
+#include <span>
 
 /*
  * The Wrap32 type represents a 32-bit unsigned integer that:
@@ -15,10 +15,14 @@ protected:
     uint32_t raw_value_ {};
 
 public:
-    explicit Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
+    explicit constexpr Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
 
     /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
-    static Wrap32 wrap( uint64_t n, Wrap32 zero_point );
+    static constexpr Wrap32 wrap( uint64_t n, Wrap32 zero_point )
+    {
+        // only the low 32 bits of n survive the wrap, and the addition wraps modulo 2^32 by itself
+        return Wrap32 { static_cast<uint32_t>(n) + zero_point.raw_value_ };
+    }
 
     /*
      * The unwrap method returns an absolute sequence number that wraps to this Wrap32, given the zero point
@@ -27,11 +31,27 @@ public:
      * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
      * The unwrap method should return the one that is closest to the checkpoint.
      */
-    uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
+    constexpr uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+    {
+        // distance from the checkpoint forward to the next candidate, mod 2^32
+        const uint64_t ahead = static_cast<uint32_t>(raw_value_ - zero_point.raw_value_ - static_cast<uint32_t>(checkpoint));
+        const uint64_t behind = (uint64_t {1} << 32) - ahead; // distance back to the previous candidate
 
-    Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
-    bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
+        // go back only when that candidate is strictly closer and not below zero (a tie goes forward)
+        return (ahead > (uint64_t {1} << 31) and checkpoint >= behind) ? checkpoint - behind : checkpoint + ahead;
+    }
+
+    /*
+     * Unwrap every seqno in `seqnos` against the same zero point and checkpoint, into the matching element
+     * of `out` (which must be at least as long). Each result equals what unwrap() would return; whole
+     * vectors are done with AVX2 or SSE4.2 when the CPU has them.
+     */
+    static void unwrap_batch( std::span<const Wrap32> seqnos,
+                              Wrap32 zero_point,
+                              uint64_t checkpoint,
+                              std::span<uint64_t> out );
+
+    constexpr Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+    constexpr bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
     void operator+=(uint32_t n) {raw_value_ += n;}
 };
-
-uint64_t get_gap_to_checkpoint(uint64_t times, uint64_t checkpoint, uint64_t offset);
@@ -0,0 +1,112 @@
+#include "benchmark_common.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+uint64_t allocations = 0; // NOLINT(*-non-const-global-variables)
+}
+
+void* operator new( size_t size )
+{
+  ++allocations;
+  if ( void* ptr = malloc( size ) ) { // NOLINT(*-no-malloc)
+    return ptr;
+  }
+  throw bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+uint64_t allocation_count()
+{
+  return allocations;
+}
+
+double BenchmarkResult::metric( string_view name ) const
+{
+  for ( const auto& [metric_name, value] : metrics ) {
+    if ( metric_name == name ) {
+      return visit( []( auto v ) { return static_cast<double>( v ); }, value );
+    }
+  }
+  throw runtime_error( "no metric called " + string { name } );
+}
+
+void print( const BenchmarkResult& result )
+{
+  cerr << "            ";
+  for ( const auto& [name, value] : result.labels ) {
+    cerr << " " << value;
+  }
+  cerr << ":";
+  for ( const auto& [name, value] : result.metrics ) {
+    cerr << " " << name << " " << fixed << setprecision( 2 );
+    visit( []( auto v ) { cerr << v; }, value );
+  }
+  cerr << "\n";
+}
+
+string to_json( string_view benchmark_name, const vector<BenchmarkResult>& results )
+{
+  ostringstream out;
+  out << fixed << setprecision( 3 );
+  out << "{\n  \"benchmark\": \"" << benchmark_name << "\",\n  \"results\": [\n";
+  for ( size_t i = 0; i < results.size(); ++i ) {
+    const char* separator = "";
+    out << "    { ";
+    for ( const auto& [name, value] : results[i].labels ) {
+      out << separator << "\"" << name << "\": \"" << value << "\"";
+      separator = ", ";
+    }
+    for ( const auto& [name, value] : results[i].metrics ) {
+      out << separator << "\"" << name << "\": ";
+      visit( [&]( auto v ) { out << v; }, value );
+      separator = ", ";
+    }
+    out << " }" << ( i + 1 < results.size() ? "," : "" ) << "\n";
+  }
+  out << "  ]\n}\n";
+  return out.str();
+}
+
+int run_benchmark( int argc,
+                   char* argv[], // NOLINT(*-avoid-c-arrays)
+                   string_view benchmark_name,
+                   const function<vector<BenchmarkResult>()>& body )
+{
+  try {
+    if ( argc > 2 ) {
+      cerr << "Usage: " << argv[0] << " [OUTPUT.json]\n"; // NOLINT(*-pointer-arithmetic)
+      return EXIT_FAILURE;
+    }
+
+    const string json = to_json( benchmark_name, body() );
+    if ( argc == 2 ) {
+      ofstream { argv[1] } << json; // NOLINT(*-pointer-arithmetic)
+    } else {
+      cout << json;
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
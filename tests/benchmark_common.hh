@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// One row of a benchmark's JSON output: what was run (written as strings), then what was measured
+// (written as numbers, doubles with three decimals), each in order
+struct BenchmarkResult
+{
+  std::vector<std::pair<std::string, std::string>> labels;
+  std::vector<std::pair<std::string, std::variant<uint64_t, double>>> metrics;
+
+  double metric( std::string_view name ) const; // throws if there is no metric called `name`
+};
+
+// Report a result on stderr, as "labels: name value ..."
+void print( const BenchmarkResult& result );
+
+std::string to_json( std::string_view benchmark_name, const std::vector<BenchmarkResult>& results );
+
+// How many heap allocations the program has made so far. Linking benchmark_common.cc replaces the
+// global operator new to count them.
+uint64_t allocation_count();
+
+// The whole of a benchmark's main(): run `body` and write its results as JSON to the file named by the
+// one optional argument, or else to stdout
+int run_benchmark( int argc,
+                   char* argv[], // NOLINT(*-avoid-c-arrays)
+                   std::string_view benchmark_name,
+                   const std::function<std::vector<BenchmarkResult>()>& body );
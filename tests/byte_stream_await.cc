@@ -0,0 +1,142 @@
+#include "byte_stream.hh"
+
+#include <coroutine>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// A minimal eagerly-started coroutine that runs to completion on whichever call resumes it
+struct Task
+{
+  struct promise_type
+  {
+    Task get_return_object() { return {}; }
+    suspend_never initial_suspend() noexcept { return {}; }
+    suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { terminate(); }
+  };
+};
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "ByteStream awaitables: expected " + what );
+  }
+}
+
+// Reads everything in batches of at least `low_water` bytes, without ever polling
+Task consumer( Reader& reader, uint64_t low_water, string& out, int& wakeups )
+{
+  while ( not reader.is_finished() ) {
+    co_await reader.readable( low_water );
+    ++wakeups;
+    string batch;
+    read( reader, reader.bytes_buffered(), batch );
+    out += batch;
+  }
+}
+
+Task producer( Writer& writer, const string& data, uint64_t chunk, int& wakeups )
+{
+  for ( size_t i = 0; i < data.size(); i += chunk ) {
+    co_await writer.writable( chunk );
+    ++wakeups;
+    writer.push( data.substr( i, chunk ) );
+  }
+  writer.close();
+}
+
+void reader_waits_for_low_water()
+{
+  ByteStream bs { 10 };
+  string out;
+  int wakeups = 0;
+
+  consumer( bs.reader(), 4, out, wakeups );
+  expect( wakeups == 0, "the consumer to suspend on an empty stream" );
+
+  bs.writer().push( "ab" );
+  expect( wakeups == 0, "the consumer to stay suspended below the low-water mark" );
+  bs.writer().push( "cd" );
+  expect( wakeups == 1 and out == "abcd", "the consumer to run once the low-water mark is reached" );
+
+  bs.writer().push( "e" );
+  expect( wakeups == 1, "the consumer to wait for the next batch" );
+  bs.writer().close();
+  expect( wakeups == 2 and out == "abcde", "close() to wake the consumer" );
+  expect( bs.reader().is_finished(), "the consumer to drain the stream" );
+}
+
+void writer_waits_for_space()
+{
+  ByteStream bs { 6 };
+  const string data = "0123456789";
+  int wakeups = 0;
+
+  producer( bs.writer(), data, 4, wakeups );
+  expect( wakeups == 1 and bs.reader().bytes_buffered() == 4, "the producer to push until the stream is full" );
+
+  bs.reader().pop( 1 );
+  expect( wakeups == 1, "the producer to wait until 4 bytes are free" );
+  bs.reader().pop( 1 );
+  expect( wakeups == 2 and bs.writer().bytes_pushed() == 8, "the producer to run once 4 bytes are free" );
+
+  bs.reader().pop( 6 );
+  expect( wakeups == 3 and bs.writer().is_closed(), "the producer to finish" );
+  string rest;
+  read( bs.reader(), 10, rest );
+  expect( rest == "89", "the last chunk to be readable" );
+}
+
+void both_sides()
+{
+  ByteStream bs { 7 };
+  string data;
+  for ( int i = 0; i < 1000; ++i ) {
+    data += static_cast<char>( 'a' + i % 26 );
+  }
+  string out;
+  int consumer_wakeups = 0;
+  int producer_wakeups = 0;
+
+  consumer( bs.reader(), 5, out, consumer_wakeups );
+  producer( bs.writer(), data, 3, producer_wakeups );
+
+  expect( out == data, "a coroutine pipeline to transfer every byte" );
+  expect( bs.reader().is_finished(), "the pipeline to finish the stream" );
+}
+
+void error_wakes_writer()
+{
+  ByteStream bs { 2 };
+  bs.writer().push( "ab" );
+  const string data = "cd";
+  int wakeups = 0;
+  producer( bs.writer(), data, 2, wakeups );
+  expect( wakeups == 0, "the producer to wait on a full stream" );
+  bs.writer().set_error();
+  expect( wakeups == 1, "set_error() to wake the producer" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    reader_waits_for_low_water();
+    writer_waits_for_space();
+    both_sides();
+    error_wakes_writer();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "benchmark_common.hh"
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+string storage_name( StreamStorage storage )
+{
+  switch ( storage ) {
+    case StreamStorage::Ring:
+      return "ring";
+    case StreamStorage::Chunked:
+      return "chunked";
+    case StreamStorage::Mapped:
+      return "mapped";
+  }
+  return "unknown";
+}
+
+// Push `data` through a stream in writes of `write_size` bytes while reading it back in reads of at
+// most `read_size` bytes. An "op" is one push() or one pop().
+BenchmarkResult run( const string& data,
+                     const StreamStorage storage,
+                     const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                     const size_t write_size, // NOLINT(bugprone-easily-swappable-parameters)
+                     const size_t read_size ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  ByteStream bs { capacity, storage };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  // the producer hands over strings it already owns, as it would in a real application
+  vector<string> writes;
+  for ( size_t i = 0; i < data.size(); i += write_size ) {
+    writes.emplace_back( data.substr( i, write_size ) );
+  }
+
+  uint64_t ops = 0;
+  size_t next_write = 0;
+  const uint64_t allocations_before = allocation_count();
+  const auto start_time = steady_clock::now();
+
+  while ( not bs.reader().is_finished() ) {
+    if ( next_write == writes.size() ) {
+      if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+    } else if ( writes[next_write].size() <= bs.writer().available_capacity() ) {
+      bs.writer().push( move( writes[next_write++] ) );
+      ++ops;
+    }
+
+    if ( bs.reader().bytes_buffered() ) {
+      const auto peeked = bs.reader().peek().substr( 0, read_size );
+      output_data += peeked;
+      bs.reader().pop( peeked.size() );
+      ++ops;
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations = allocation_count() - allocations_before;
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  return { { { "storage", storage_name( storage ) } },
+           { { "capacity", capacity },
+             { "write_size", write_size },
+             { "read_size", read_size },
+             { "gbit_per_s", 8 * static_cast<double>( data.size() ) / seconds / 1e9 },
+             { "ns_per_op", seconds * 1e9 / static_cast<double>( ops ) },
+             { "allocs_per_op", static_cast<double>( allocations ) / static_cast<double>( ops ) } } };
+}
+
+vector<BenchmarkResult> program_body()
+{
+  const string data = [] {
+    default_random_engine rd { 789 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 8e6; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  vector<BenchmarkResult> results;
+  for ( const auto storage : { StreamStorage::Ring, StreamStorage::Chunked, StreamStorage::Mapped } ) {
+    for ( const size_t capacity : { 4096, 65536, 1 << 20 } ) {
+      for ( const size_t write_size : { 64, 1500, 16384, 65536 } ) {
+        if ( write_size > capacity ) {
+          continue;
+        }
+        for ( const size_t read_size : { 128, 1500, 65536 } ) {
+          results.push_back( run( data, storage, capacity, write_size, read_size ) );
+          print( results.back() );
+        }
+      }
+    }
+  }
+
+  return results;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return run_benchmark( argc, argv, "byte_stream", program_body );
+}
@@ -0,0 +1,67 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "chunked: peek stops at chunk boundary", 15, StreamStorage::Chunked };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "dog" } );
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Peek { "catdog" } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "t" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "og" } );
+      test.execute( BytesPopped { 4 } );
+      test.execute( AvailableCapacity { 13 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked: last push trimmed to capacity", 5, StreamStorage::Chunked };
+
+      test.execute( Push { "abc" } );
+      test.execute( Push { "defgh" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "abcde" } );
+
+      test.execute( Push { "" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "de" } );
+      test.execute( Push { "xyzw" } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( Peek { "dexyz" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked: pop spanning several chunks", 20, StreamStorage::Chunked };
+
+      test.execute( Push { "a" } );
+      test.execute( Push { "bc" } );
+      test.execute( Push { "def" } );
+      test.execute( Close {} );
+      test.execute( Pop { 4 } );
+      test.execute( PeekOnce { "ef" } );
+      test.execute( IsFinished { false } );
+      test.execute( Pop { 10 } );
+      test.execute( BytesPopped { 6 } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "ByteStream fd transfer: expected " + what );
+  }
+}
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  array<int, 2> fds {};
+  if ( pipe( fds.data() ) != 0 ) {
+    throw runtime_error( "pipe() failed" );
+  }
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+string read_exactly( FileDescriptor& fd, size_t len )
+{
+  string ret;
+  string buf;
+  while ( ret.size() < len ) {
+    fd.read( buf );
+    ret += buf;
+  }
+  return ret;
+}
+
+void round_trip( StreamStorage storage )
+{
+  auto [in_read, in_write] = make_pipe();
+  auto [out_read, out_write] = make_pipe();
+  ByteStream bs { 8, storage };
+
+  // leave the ring's head in the middle, so both the free space and the buffered bytes wrap around
+  bs.writer().push( "xxxxx" );
+  bs.reader().pop( 5 );
+  bs.writer().push( "ab" );
+
+  in_write.write( "cdefghijkl" );
+  expect( bs.writer().fill_from( in_read ) == 6, "fill_from() to read exactly the free space" );
+  expect( bs.writer().bytes_pushed() == 13, "fill_from() to count the bytes as pushed" );
+  expect( bs.writer().available_capacity() == 0, "the stream to be full" );
+
+  expect( bs.reader().drain_to( out_write ) == 8, "drain_to() to write every buffered byte" );
+  expect( bs.reader().bytes_popped() == 13, "drain_to() to pop the bytes it wrote" );
+  expect( bs.reader().drain_to( out_write ) == 0, "drain_to() on an empty stream to do nothing" );
+
+  expect( bs.writer().fill_from( in_read ) == 4, "fill_from() to read what is left in the pipe" );
+  expect( bs.reader().drain_to( out_write ) == 4, "drain_to() to write the rest" );
+  expect( read_exactly( out_read, 12 ) == "abcdefghijkl", "bytes to come out of the stream in order" );
+
+  in_write.close();
+  expect( bs.writer().fill_from( in_read ) == 0 and in_read.eof(), "fill_from() to report EOF" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    round_trip( StreamStorage::Ring );
+    round_trip( StreamStorage::Chunked );
+    round_trip( StreamStorage::Mapped );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
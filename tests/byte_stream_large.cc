@@ -0,0 +1,69 @@
+#include "byte_stream.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Streams far past 4 GiB through a small stream with reserve/commit, so that no byte has to be
+// copied from elsewhere; the first byte of every write carries a marker that the reader checks.
+void stress_past_4gib( const uint64_t total, const uint64_t capacity, const StreamStorage storage )
+{
+  ByteStream bs { capacity, storage };
+  queue<pair<uint64_t, char>> markers; // stream offset and value of each write's first byte
+
+  while ( bs.reader().bytes_popped() < total ) {
+    const uint64_t want = min( total - bs.writer().bytes_pushed(), capacity / 3 );
+    auto span = bs.writer().reserve( want );
+    if ( not span.empty() ) {
+      const auto marker = static_cast<char>( markers.size() + bs.writer().bytes_pushed() / 7 );
+      markers.emplace( bs.writer().bytes_pushed(), marker );
+      span[0] = marker;
+      bs.writer().commit( span.size() );
+    }
+
+    const auto view = bs.reader().peek();
+    if ( view.empty() ) {
+      throw runtime_error( "peek() returned an empty view with " + to_string( bs.reader().bytes_buffered() )
+                           + " bytes buffered" );
+    }
+    const uint64_t start = bs.reader().bytes_popped();
+    while ( not markers.empty() and markers.front().first < start + view.size() ) {
+      if ( view[markers.front().first - start] != markers.front().second ) {
+        throw runtime_error( "wrong marker at stream offset " + to_string( markers.front().first ) );
+      }
+      markers.pop();
+    }
+    bs.reader().pop( view.size() );
+  }
+
+  if ( bs.writer().bytes_pushed() != total or bs.reader().bytes_popped() != total ) {
+    throw runtime_error( "expected bytes_pushed() == bytes_popped() == " + to_string( total ) + ", got "
+                         + to_string( bs.writer().bytes_pushed() ) + " and "
+                         + to_string( bs.reader().bytes_popped() ) );
+  }
+  if ( bs.writer().available_capacity() != capacity or bs.reader().bytes_buffered() != 0 ) {
+    throw runtime_error( "stream not empty after reading everything" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    stress_past_4gib( ( uint64_t { 1 } << 32 ) + 12345, 1 << 18, StreamStorage::Ring );
+    stress_past_4gib( ( uint64_t { 1 } << 32 ) + 12345, 1 << 18, StreamStorage::Mapped );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
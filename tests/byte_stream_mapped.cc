@@ -0,0 +1,98 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+void large_wrapping_stream()
+{
+  // two release batches (1 MiB each), so each lap around the ring still releases consumed pages
+  const uint64_t capacity = 2 << 20;
+  ByteStream bs { capacity, StreamStorage::Mapped };
+
+  string chunk( 1 << 20, 0 );
+  uint64_t next_write = 0;
+  uint64_t next_read = 0;
+  for ( int round = 0; round < 6; ++round ) {
+    while ( bs.writer().available_capacity() > 0 ) {
+      for ( auto& c : chunk ) {
+        c = static_cast<char>( next_write++ % 251 );
+      }
+      const uint64_t pushed_before = bs.writer().bytes_pushed();
+      bs.writer().push( chunk );
+      next_write = bs.writer().bytes_pushed(); // the last push may have been trimmed
+      if ( bs.writer().bytes_pushed() == pushed_before ) {
+        break;
+      }
+    }
+
+    // everything buffered is visible in one piece, even across the wraparound
+    const auto view = bs.reader().peek();
+    if ( view.size() != bs.reader().bytes_buffered() ) {
+      throw runtime_error( "mapped ByteStream: peek() did not return every buffered byte" );
+    }
+    const uint64_t to_pop = view.size() - ( round % 3 ) * 12345;
+    for ( uint64_t i = 0; i < to_pop; ++i ) {
+      if ( view[i] != static_cast<char>( ( next_read + i ) % 251 ) ) {
+        throw runtime_error( "mapped ByteStream: wrong byte at index " + to_string( next_read + i ) );
+      }
+    }
+    bs.reader().pop( to_pop );
+    next_read += to_pop;
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "mapped: peek across wraparound", 4096, StreamStorage::Mapped };
+
+      test.execute( Push { string( 4000, 'a' ) } );
+      test.execute( Pop { 4000 } );
+      test.execute( Push { string( 90, 'b' ) + string( 10, 'c' ) } );
+      test.execute( PeekOnce { string( 90, 'b' ) + string( 10, 'c' ) } );
+      test.execute( PeekAll { { string( 90, 'b' ) + string( 10, 'c' ) } } );
+      test.execute( Reservable { 5000, 3996 } );
+      test.execute( ReserveAndCommit { "def" } );
+      test.execute( BytesPushed { 4103 } );
+      test.execute( AvailableCapacity { 3993 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "mapped: capacity not a multiple of the page size", 5, StreamStorage::Mapped };
+
+      test.execute( Push { "abcdefg" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "abcde" } );
+      test.execute( Pop { 3 } );
+      test.execute( Push { "xyzw" } );
+      test.execute( PeekOnce { "dexyz" } );
+      test.execute( Close {} );
+      test.execute( ReadAll { "dexyz" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ByteStreamTestHarness test { "mapped: zero capacity", 0, StreamStorage::Mapped };
+
+      test.execute( Push { "a" } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( PeekAll { {} } );
+    }
+
+    large_wrapping_stream();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
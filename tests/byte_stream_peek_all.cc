@@ -0,0 +1,64 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_all on empty stream", 4 };
+
+      test.execute( PeekAll { {} } );
+      test.execute( Push { "ab" } );
+      test.execute( PeekAll { { "ab" } } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekAll { {} } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all across ring wraparound", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "def" } );
+      test.execute( PeekOnce { "cd" } );
+      test.execute( PeekAll { { "cd", "ef" } } );
+      test.execute( ReadAll { "cdef" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all over chunks", 10, StreamStorage::Chunked };
+
+      test.execute( Push { "ab" } );
+      test.execute( Push { "cde" } );
+      test.execute( Push { "fghijkl" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAll { { "b", "cde", "fghij" } } );
+      test.execute( ReadAll { "bcdefghij" } );
+      test.execute( BytesPopped { 10 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "pop through the end of the ring", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "def" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAll { { "d", "ef" } } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAll { { "ef" } } );
+      test.execute( Push { "gh" } );
+      test.execute( PeekAll { { "efgh" } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_slice shares chunks", 20, StreamStorage::Chunked };
+
+      test.execute( Push { "abc" } );
+      test.execute( Push { "defgh" } );
+      test.execute( PeekSlice { 0, 3, "abc" }.shared( true ) );
+      test.execute( PeekSlice { 4, 2, "ef" }.shared( true ) );
+      test.execute( PeekSlice { 1, 1, "b" }.shared( true ) );
+      test.execute( Pop { 2 } );
+      test.execute( PeekSlice { 0, 1, "c" }.shared( true ) );
+      test.execute( PeekSlice { 1, 5, "defgh" }.shared( true ) );
+      test.execute( Pop { 4 } );
+      test.execute( PeekSlice { 0, 2, "gh" }.shared( true ) );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_slice across chunks copies", 20, StreamStorage::Chunked };
+
+      test.execute( Push { "abc" } );
+      test.execute( Push { "def" } );
+      test.execute( PeekSlice { 1, 4, "bcde" }.shared( false ) );
+      test.execute( PeekSlice { 2, 100, "cdef" } );
+      test.execute( PeekSlice { 6, 1, "" } );
+      test.execute( PeekSlice { 100, 1, "" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_slice copies out of the ring", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( PeekSlice { 1, 2, "bc" }.shared( false ) );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "def" } );
+      test.execute( PeekAll { { "cd", "ef" } } );
+      test.execute( PeekSlice { 1, 3, "def" }.shared( false ) );
+      test.execute( ReadAll { "cdef" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_slice copies out of the mapped ring", 4096, StreamStorage::Mapped };
+
+      test.execute( Push { "hello" } );
+      test.execute( PeekSlice { 1, 3, "ell" }.shared( false ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "reserve/commit into empty ring", 4 };
+
+      test.execute( Reservable { 10, 4 } );
+      test.execute( Reservable { 3, 3 } );
+      test.execute( ReserveAndCommit { "ab" } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( AvailableCapacity { 2 } );
+      test.execute( PeekOnce { "ab" } );
+      test.execute( ReserveAndCommit { "cdef" } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( Reservable { 1, 0 } );
+      test.execute( Peek { "abcd" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve stops at the end of the ring", 4 };
+
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 2 } );
+      test.execute( Reservable { 4, 1 } );
+      test.execute( ReserveAndCommit { "d" } );
+      test.execute( Reservable { 4, 2 } );
+      test.execute( ReserveAndCommit { "ef" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekAll { { "cd", "ef" } } );
+      test.execute( BytesPushed { 6 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve/commit on chunked storage", 6, StreamStorage::Chunked };
+
+      test.execute( Push { "ab" } );
+      test.execute( Reservable { 10, 4 } );
+      test.execute( ReserveAndCommit { "cde" } );
+      test.execute( PeekAll { { "ab", "cde" } } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( ReserveAndCommit { "" } );
+      test.execute( PeekAll { { "ab", "cde" } } );
+      test.execute( AvailableCapacity { 1 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve after close", 4 };
+
+      test.execute( Close {} );
+      test.execute( Reservable { 4, 0 } );
+      test.execute( HasError { true } );
+    }
+
+    {
+      ByteStream bs { 16 };
+      array<int, 2> fds {};
+      if ( pipe( fds.data() ) != 0 ) {
+        throw runtime_error( "pipe() failed" );
+      }
+      FileDescriptor read_end { fds[0] };
+      FileDescriptor write_end { fds[1] };
+      write_end.write( "hello, world" );
+
+      auto span = bs.writer().reserve( 5 );
+      bs.writer().commit( read_end.read( span ) );
+      span = bs.writer().reserve( 100 );
+      bs.writer().commit( read_end.read( span ) );
+
+      if ( bs.reader().peek() != "hello, world" or bs.writer().bytes_pushed() != 12 ) {
+        throw runtime_error( "reading from a FileDescriptor into reserved space produced \""
+                             + string { bs.reader().peek() } + "\"" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "SPSCByteStream: expected " + what );
+  }
+}
+
+void single_threaded()
+{
+  SPSCByteStream bs { 4 };
+
+  expect( bs.writer().push( "abc" ) == 3, "push of 3 bytes into capacity 4 to take all of them" );
+  expect( bs.writer().available_capacity() == 1, "available_capacity() == 1" );
+  expect( bs.reader().peek() == "abc", "peek() == \"abc\"" );
+
+  bs.reader().pop( 2 );
+  expect( bs.reader().bytes_popped() == 2, "bytes_popped() == 2" );
+  expect( bs.writer().push( "defgh" ) == 3, "push to be trimmed to the 3 free bytes" );
+  expect( bs.reader().peek() == "cd", "peek() to stop at the end of the ring" );
+
+  bs.reader().pop( 2 );
+  expect( bs.reader().peek() == "ef", "peek() == \"ef\" after wrapping" );
+  expect( bs.reader().bytes_buffered() == 2, "bytes_buffered() == 2" );
+
+  bs.writer().close();
+  expect( bs.writer().is_closed(), "is_closed()" );
+  expect( not bs.reader().is_finished(), "stream with buffered bytes not to be finished" );
+  bs.reader().pop( 10 );
+  expect( bs.reader().bytes_popped() == 6, "pop() past the end to be clamped" );
+  expect( bs.reader().is_finished(), "closed and drained stream to be finished" );
+
+  expect( bs.writer().push( "x" ) == 0, "push after close to be rejected" );
+  expect( bs.reader().has_error(), "push after close to set the error flag" );
+}
+
+void two_threads( const size_t input_len, const size_t capacity, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream bs { capacity };
+
+  thread producer( [&bs, &data, random_seed] {
+    default_random_engine prd { random_seed + 1 };
+    uniform_int_distribution<size_t> size_dist { 1, 3 * bs.writer().available_capacity() / 2 };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      const uint64_t len = bs.writer().push( string_view { data }.substr( pushed, size_dist( prd ) ) );
+      if ( len == 0 ) {
+        this_thread::yield();
+      }
+      pushed += len;
+    }
+    bs.writer().close();
+  } );
+
+  string output;
+  while ( not bs.reader().is_finished() ) {
+    const auto view = bs.reader().peek();
+    if ( view.empty() ) {
+      this_thread::yield();
+    }
+    output += view;
+    bs.reader().pop( view.size() );
+  }
+  producer.join();
+
+  expect( output == data, "bytes read by the consumer thread to match those written by the producer" );
+  expect( bs.reader().bytes_popped() == input_len, "bytes_popped() == input length" );
+}
+
+// Same transfer, but both sides sleep in wait_writable()/wait_readable() instead of spinning
+void two_threads_blocking( const size_t input_len, const size_t capacity, const size_t low_water )
+{
+  string data;
+  for ( size_t i = 0; i < input_len; ++i ) {
+    data += static_cast<char>( 'a' + i % 26 );
+  }
+
+  SPSCByteStream bs { capacity };
+
+  thread producer( [&bs, &data] {
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      bs.writer().wait_writable( 100 );
+      pushed += bs.writer().push( string_view { data }.substr( pushed, 100 ) );
+    }
+    bs.writer().close();
+  } );
+
+  string output;
+  while ( not bs.reader().is_finished() ) {
+    bs.reader().wait_readable( low_water );
+    expect( bs.reader().bytes_buffered() >= min( low_water, capacity ) or bs.writer().is_closed(),
+            "wait_readable() to return only once the low-water mark is reached" );
+    const auto view = bs.reader().peek();
+    output += view;
+    bs.reader().pop( view.size() );
+  }
+  producer.join();
+
+  expect( output == data, "bytes read by the blocking consumer to match those written" );
+}
+
+void error_wakes_reader()
+{
+  SPSCByteStream bs { 16 };
+  thread failer( [&bs] { bs.writer().set_error(); } );
+  bs.reader().wait_readable( 8 );
+  failer.join();
+  expect( bs.reader().has_error(), "wait_readable() to return once the stream has an error" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    single_threaded();
+    two_threads( 100000, 17, 4242 );
+    two_threads( 1000000, 4096, 1414 );
+    two_threads_blocking( 100000, 1000, 1 );
+    two_threads_blocking( 100000, 1000, 500 );
+    two_threads_blocking( 100000, 300, 5000 );
+    error_wakes_reader();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
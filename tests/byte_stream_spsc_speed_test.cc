@@ -0,0 +1,196 @@
+#include "byte_stream.hh"
+#include "spsc_byte_stream.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// The alternative to SPSCByteStream: an ordinary ByteStream with every call made under one mutex, and a
+// condition variable to block on
+struct LockedByteStream
+{
+  ByteStream bs;
+  mutex m {};
+  condition_variable progress {};
+
+  explicit LockedByteStream( uint64_t capacity ) : bs( capacity ) {}
+
+  uint64_t push( string_view data )
+  {
+    uint64_t pushed = 0;
+    {
+      const lock_guard lock { m };
+      const uint64_t before = bs.writer().bytes_pushed();
+      bs.writer().push( string { data } );
+      pushed = bs.writer().bytes_pushed() - before;
+    }
+    progress.notify_all();
+    return pushed;
+  }
+
+  void close()
+  {
+    {
+      const lock_guard lock { m };
+      bs.writer().close();
+    }
+    progress.notify_all();
+  }
+
+  // copy out up to `read_size` of the next contiguous bytes, return how many
+  size_t read( string& out, size_t read_size )
+  {
+    size_t popped = 0;
+    {
+      const lock_guard lock { m };
+      const auto view = bs.reader().peek().substr( 0, read_size );
+      out += view;
+      bs.reader().pop( view.size() );
+      popped = view.size();
+    }
+    progress.notify_all();
+    return popped;
+  }
+
+  void wait_writable()
+  {
+    unique_lock lock { m };
+    progress.wait( lock, [&] { return bs.writer().available_capacity() > 0; } );
+  }
+
+  void wait_readable()
+  {
+    unique_lock lock { m };
+    progress.wait( lock, [&] { return bs.reader().bytes_buffered() > 0 or bs.writer().is_closed(); } );
+  }
+
+  bool is_finished()
+  {
+    const lock_guard lock { m };
+    return bs.reader().is_finished();
+  }
+};
+
+struct SPSC
+{
+  SPSCByteStream bs;
+
+  explicit SPSC( uint64_t capacity ) : bs( capacity ) {}
+
+  uint64_t push( string_view data ) { return bs.writer().push( data ); }
+  void close() { bs.writer().close(); }
+
+  size_t read( string& out, size_t read_size )
+  {
+    const auto view = bs.reader().peek().substr( 0, read_size );
+    out += view;
+    bs.reader().pop( view.size() );
+    return view.size();
+  }
+
+  bool is_finished() const { return bs.reader().is_finished(); }
+
+  void wait_writable() const { bs.writer().wait_writable(); }
+  void wait_readable() const { bs.reader().wait_readable(); }
+};
+
+template<class Stream>
+void speed_test( const string& name,
+                 const string& data,
+                 const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t write_size, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  Stream stream { capacity };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+
+  thread producer( [&] {
+    const string_view input { data };
+    size_t pushed = 0;
+    while ( pushed < input.size() ) {
+      const uint64_t len = stream.push( input.substr( pushed, write_size ) );
+      if ( len == 0 ) {
+        stream.wait_writable(); // sleep until the consumer makes room, rather than spin against it for a core
+      }
+      pushed += len;
+    }
+    stream.close();
+  } );
+
+  while ( not stream.is_finished() ) {
+    if ( stream.read( output_data, read_size ) == 0 ) {
+      stream.wait_readable();
+    }
+  }
+  producer.join();
+
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto bytes_per_second = static_cast<double>( data.size() ) / test_duration.count();
+  auto bits_per_second = 8 * bytes_per_second;
+  auto gigabits_per_second = bits_per_second / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << " with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
+       << " across two threads reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "             " << name << " throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+               << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( name + " did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  const string data = [] {
+    default_random_engine rd { 789 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 1e7; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  speed_test<LockedByteStream>( "ByteStream+mutex", data, 32768, 1500, 1500 );
+  speed_test<SPSC>( "SPSCByteStream", data, 32768, 1500, 1500 );
+  speed_test<LockedByteStream>( "ByteStream+mutex", data, 262144, 16384, 16384 );
+  speed_test<SPSC>( "SPSCByteStream", data, 262144, 16384, 16384 );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
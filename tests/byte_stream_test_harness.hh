@@ -3,9 +3,12 @@
 #include "byte_stream.hh"
 #include "common.hh"
 
+#include <algorithm>
 #include <concepts>
+#include <functional>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -16,8 +19,8 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, StreamStorage storage = StreamStorage::Ring )
+    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -46,6 +49,25 @@ struct SetError : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.writer().set_error(); }
 };
 
+struct ReserveAndCommit : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit ReserveAndCommit( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "reserve( " + std::to_string( data_.size() ) + " ), fill in and commit \"" + Printer::prettify( data_ )
+           + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    auto span = bs.writer().reserve( data_.size() );
+    const size_t len = std::min( span.size(), data_.size() );
+    std::copy_n( data_.data(), len, span.data() );
+    bs.writer().commit( len );
+  }
+};
+
 struct Pop : public Action<ByteStream>
 {
   size_t len_;
@@ -107,6 +129,97 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAll : public Expectation<ByteStream>
+{
+  std::vector<std::string> regions_;
+
+  explicit PeekAll( std::vector<std::string> regions ) : regions_( move( regions ) ) {}
+
+  std::string description() const override
+  {
+    std::string ret = "peek_all() gives {";
+    for ( const auto& region : regions_ ) {
+      ret += " \"" + Printer::prettify( region ) + "\"";
+    }
+    return ret + " }";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto views = bs.reader().peek_all();
+    if ( views.size() != regions_.size() ) {
+      throw ExpectationViolation { "Expected " + std::to_string( regions_.size() ) + " regions from peek_all(), "
+                                   + "but got " + std::to_string( views.size() ) };
+    }
+    for ( size_t i = 0; i < views.size(); ++i ) {
+      if ( views[i] != regions_[i] ) {
+        throw ExpectationViolation { "Expected region " + std::to_string( i ) + " to be \""
+                                     + Printer::prettify( regions_[i] ) + "\", but found \""
+                                     + Printer::prettify( views[i] ) + "\"" };
+      }
+    }
+  }
+};
+
+struct PeekSlice : public Expectation<ByteStream>
+{
+  uint64_t offset_;
+  uint64_t len_;
+  std::string output_;
+  std::optional<bool> shared_ {};
+
+  PeekSlice( uint64_t offset, uint64_t len, std::string output )
+    : offset_( offset ), len_( len ), output_( move( output ) )
+  {}
+
+  // Expect the slice to point into the stream's own storage (true) or at a copy of its bytes (false)
+  PeekSlice& shared( bool shared )
+  {
+    shared_ = shared;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    std::string ret = "peek_slice( " + std::to_string( offset_ ) + ", " + std::to_string( len_ ) + " ) gives \""
+                      + Printer::prettify( output_ ) + "\"";
+    if ( shared_.has_value() ) {
+      ret += shared_.value() ? ", sharing the stream's storage" : ", as a copy";
+    }
+    return ret;
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const BufferSlice slice = bs.reader().peek_slice( offset_, len_ );
+    if ( slice.view() != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" from peek_slice(), "
+                                   + "but found \"" + Printer::prettify( slice.view() ) + "\"" };
+    }
+
+    if ( shared_.has_value() and not output_.empty() ) {
+      const auto views = bs.reader().peek_all();
+      const bool is_shared = std::any_of( views.begin(), views.end(), [&]( std::string_view view ) {
+        return std::less_equal<> {}( view.data(), slice.view().data() )
+               and std::less<> {}( slice.view().data(), view.data() + view.size() );
+      } );
+      if ( is_shared != shared_.value() ) {
+        throw ExpectationViolation { std::string( "Expected peek_slice() to " )
+                                     + ( shared_.value() ? "share the stream's storage" : "copy the bytes" )
+                                     + ", but it did not" };
+      }
+    }
+  }
+};
+
+struct Reservable : public ExpectNumber<ByteStream, uint64_t>
+{
+  uint64_t request_;
+  Reservable( uint64_t request, uint64_t num ) : ExpectNumber( num ), request_( request ) {}
+  std::string name() const override { return "reserve( " + std::to_string( request_ ) + " ).size()"; }
+  size_t value( ByteStream& bs ) const override { return bs.writer().reserve( request_ ).size(); }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
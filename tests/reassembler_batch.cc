@@ -0,0 +1,107 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Feed random overlapping segments in shuffled batches, reading as we go, and check the stream
+void random_batches( Reassembler reassembler, const string& label )
+{
+  default_random_engine rd { 1918 };
+  const size_t stream_size = 20000;
+  string data;
+  for ( size_t i = 0; i < stream_size; ++i ) {
+    data += static_cast<char>( 'a' + rd() % 26 );
+  }
+
+  vector<Reassembler::Segment> segments;
+  for ( size_t i = 0; i < stream_size; ) {
+    const size_t len = 1 + rd() % 300;
+    const size_t start = i - min<size_t>( i, rd() % 50 ); // overlap what came before
+    const size_t end = min( stream_size, i + len );
+    segments.push_back( { start, Buffer { data.substr( start, end - start ) }, end == stream_size } );
+    i = end;
+  }
+
+  ByteStream stream { 4000 };
+  string output;
+  for ( size_t i = 0; i < segments.size(); ) {
+    // shuffle within a window of batches so some bytes must wait for the next batch
+    const size_t batch_size = min<size_t>( segments.size() - i, 1 + rd() % 16 );
+    vector<Reassembler::Segment> batch( segments.begin() + i, segments.begin() + i + batch_size );
+    shuffle( batch.begin(), batch.end(), rd );
+    if ( i + batch_size < segments.size() and rd() % 2 ) {
+      batch.push_back( segments[i + batch_size] ); // sometimes a segment arrives early, and again later
+    }
+    reassembler.insert_batch( batch, stream.writer() );
+    i += batch_size;
+
+    string chunk;
+    read( stream.reader(), stream.reader().bytes_buffered(), chunk );
+    output += chunk;
+  }
+
+  if ( output != data or not stream.reader().is_finished() or reassembler.bytes_pending() != 0 ) {
+    throw runtime_error( "insert_batch (" + label + ") did not reassemble the stream" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "batch: reordered and overlapping", 20 };
+
+      test.execute( InsertBatch { { { 4, "ef"s, false }, { 0, "abc"s, false }, { 2, "cd"s, false } } } );
+      test.execute( BytesPushed( 6 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdef" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch: held bytes bridge two segments", 20, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { "de", 3 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( InsertBatch { { { 5, "fg"s, false }, { 8, "i"s, true }, { 0, "abc"s, false } } } );
+      test.execute( BytesPushed( 7 ) );
+      test.execute( BytesPending( 1 ) );
+      test.execute( ReadAll( "abcdefg" ) );
+      test.execute( IsFinished { false } );
+      test.execute( InsertBatch { { { 7, "h"s, false } } } );
+      test.execute( ReadAll( "hi" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "batch: gap left open, window respected", 4 };
+
+      test.execute( InsertBatch { { { 1, "bcdef"s, false }, { 0, "a"s, false }, { 7, "h"s, false } } } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcd" ) );
+      test.execute( InsertBatch { { { 6, "gh"s, true }, { 5, "f"s, false } } } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( InsertBatch { { { 4, "e"s, false } } } );
+      test.execute( ReadAll( "efgh" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    random_batches( Reassembler {}, "map" );
+    random_batches( Reassembler { ReassemblerStorage::Bitmap }, "bitmap" );
+    ReassemblerPool pool { 1 << 20 };
+    random_batches( Reassembler { pool }, "pooled" );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
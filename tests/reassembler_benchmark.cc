@@ -0,0 +1,250 @@
+#include "benchmark_common.hh"
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+struct Delivery
+{
+  uint64_t first_index;
+  uint64_t length;
+};
+
+// A workload is the order in which the pieces of a stream reach the Reassembler. Each one keeps its
+// reordering inside consecutive blocks of `capacity` bytes, so that every piece fits in the window
+// when it arrives, and nothing has to be retransmitted for the stream to complete.
+struct Workload
+{
+  string name;
+  size_t capacity;
+  bool lazy_reader; // read only what the next piece needs to fit, keeping the window nearly full
+  function<vector<Delivery>( size_t stream_size, default_random_engine& rd )> deliveries;
+};
+
+// Cut [begin, end) into pieces of random length in [min_len, max_len]
+vector<Delivery> cut( uint64_t begin, uint64_t end, uint64_t min_len, uint64_t max_len, default_random_engine& rd )
+{
+  vector<Delivery> pieces;
+  uniform_int_distribution<uint64_t> length { min_len, max_len };
+  for ( uint64_t i = begin; i < end; ) {
+    const uint64_t len = min( length( rd ), end - i );
+    pieces.push_back( { i, len } );
+    i += len;
+  }
+  return pieces;
+}
+
+// Concatenate the deliveries `block` chooses for each block of `capacity` bytes, in turn
+vector<Delivery> per_block( size_t stream_size,
+                            size_t capacity,
+                            const function<vector<Delivery>( uint64_t begin, uint64_t end )>& block )
+{
+  vector<Delivery> ret;
+  for ( uint64_t begin = 0; begin < stream_size; begin += capacity ) {
+    const auto pieces = block( begin, min<uint64_t>( begin + capacity, stream_size ) );
+    ret.insert( ret.end(), pieces.begin(), pieces.end() );
+  }
+  return ret;
+}
+
+vector<Workload> workloads()
+{
+  return {
+    { "reorder_small_holes",
+      65536,
+      false,
+      []( size_t size, default_random_engine& rd ) {
+        // MSS-sized segments, shuffled, with 1 in 20 lost and retransmitted at the end of the window
+        return per_block( size, 65536, [&]( uint64_t begin, uint64_t end ) {
+          auto pieces = cut( begin, end, 1460, 1460, rd );
+          shuffle( pieces.begin(), pieces.end(), rd );
+          vector<Delivery> lost;
+          vector<Delivery> ret;
+          for ( const auto& piece : pieces ) {
+            ( rd() % 20 == 0 ? lost : ret ).push_back( piece );
+          }
+          ret.insert( ret.end(), lost.begin(), lost.end() );
+          return ret;
+        } );
+      } },
+    { "tiny_segment_flood",
+      65536,
+      false,
+      []( size_t size, default_random_engine& rd ) {
+        // 1 to 8 byte segments, with neighbours swapped a third of the time
+        return per_block( size, 65536, [&]( uint64_t begin, uint64_t end ) {
+          auto pieces = cut( begin, end, 1, 8, rd );
+          for ( size_t i = 1; i < pieces.size(); ++i ) {
+            if ( rd() % 3 == 0 ) {
+              swap( pieces[i - 1], pieces[i] );
+            }
+          }
+          return pieces;
+        } );
+      } },
+    { "duplicate_retransmits",
+      65536,
+      false,
+      []( size_t size, default_random_engine& rd ) {
+        // every segment arrives 1 to 4 times in a shuffled window, and the previous window again too
+        optional<vector<Delivery>> previous;
+        return per_block( size, 65536, [&]( uint64_t begin, uint64_t end ) {
+          vector<Delivery> ret;
+          for ( const auto& piece : cut( begin, end, 1460, 1460, rd ) ) {
+            for ( uint64_t copies = 1 + rd() % 4; copies > 0; --copies ) {
+              ret.push_back( piece );
+            }
+          }
+          shuffle( ret.begin(), ret.end(), rd );
+          if ( previous ) {
+            ret.insert( ret.begin(), previous->begin(), previous->end() );
+          }
+          previous = cut( begin, end, 1460, 1460, rd );
+          return ret;
+        } );
+      } },
+    { "reverse_order",
+      65536,
+      false,
+      []( size_t size, default_random_engine& rd ) {
+        // each window arrives back to front, so everything but its first segment waits
+        return per_block( size, 65536, [&]( uint64_t begin, uint64_t end ) {
+          auto pieces = cut( begin, end, 1460, 1460, rd );
+          reverse( pieces.begin(), pieces.end() );
+          return pieces;
+        } );
+      } },
+    { "near_capacity",
+      16384,
+      true,
+      []( size_t size, default_random_engine& rd ) {
+        // a slow reader keeps the window nearly full while segments arrive shuffled up to its edge
+        return per_block( size, 16384, [&]( uint64_t begin, uint64_t end ) {
+          auto pieces = cut( begin, end, 536, 1460, rd );
+          shuffle( pieces.begin(), pieces.end(), rd );
+          return pieces;
+        } );
+      } },
+  };
+}
+
+struct Engine
+{
+  string name;
+  function<Reassembler()> make;
+};
+
+BenchmarkResult run( const string& data,
+                     const Workload& workload,
+                     const vector<Delivery>& deliveries,
+                     const Engine& engine )
+{
+  // the payloads are built before the clock starts, as if they came from the network that way
+  vector<string> payloads;
+  payloads.reserve( deliveries.size() );
+  for ( const auto& delivery : deliveries ) {
+    payloads.emplace_back( data.substr( delivery.first_index, delivery.length ) );
+  }
+
+  ByteStream stream { workload.capacity };
+  Reassembler reassembler = engine.make();
+  string output_data;
+  output_data.reserve( data.size() );
+  uint64_t peak_pending = 0;
+
+  const auto read = [&]( uint64_t len ) {
+    while ( len > 0 and stream.reader().bytes_buffered() > 0 ) {
+      const auto peeked = stream.reader().peek().substr( 0, len );
+      output_data += peeked;
+      stream.reader().pop( peeked.size() );
+      len -= peeked.size();
+    }
+  };
+
+  const uint64_t allocations_before = allocation_count();
+  const auto start_time = steady_clock::now();
+
+  for ( size_t i = 0; i < deliveries.size(); ++i ) {
+    const uint64_t end = deliveries[i].first_index + deliveries[i].length;
+    if ( workload.lazy_reader ) {
+      const uint64_t window_end = stream.reader().bytes_popped() + workload.capacity;
+      if ( end > window_end ) {
+        read( end - window_end );
+      }
+    }
+    reassembler.insert( deliveries[i].first_index, move( payloads[i] ), end == data.size(), stream.writer() );
+    peak_pending = max( peak_pending, reassembler.bytes_pending() );
+    if ( not workload.lazy_reader ) {
+      read( UINT64_MAX );
+    }
+  }
+  read( UINT64_MAX );
+
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations = allocation_count() - allocations_before;
+
+  if ( not stream.reader().is_finished() or data != output_data ) {
+    throw runtime_error( workload.name + " on " + engine.name + ": stream not reassembled correctly" );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const auto inserts = static_cast<double>( deliveries.size() );
+  return { { { "workload", workload.name }, { "engine", engine.name } },
+           { { "capacity", workload.capacity },
+             { "inserts", deliveries.size() },
+             { "gbit_per_s", 8 * static_cast<double>( data.size() ) / seconds / 1e9 },
+             { "ns_per_insert", seconds * 1e9 / inserts },
+             { "peak_pending_bytes", peak_pending },
+             { "allocs", allocations },
+             { "allocs_per_insert", static_cast<double>( allocations ) / inserts } } };
+}
+
+vector<BenchmarkResult> program_body()
+{
+  const string data = [] {
+    default_random_engine rd { 1122 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < 4e6; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  ReassemblerPool pool { 64 << 20 };
+  const vector<Engine> engines {
+    { "map", [] { return Reassembler {}; } },
+    { "bitmap", [] { return Reassembler { ReassemblerStorage::Bitmap }; } },
+    { "pooled", [&] { return Reassembler { pool }; } },
+  };
+
+  vector<BenchmarkResult> results;
+  for ( const auto& workload : workloads() ) {
+    default_random_engine rd { 3344 };
+    const auto deliveries = workload.deliveries( data.size(), rd );
+    for ( const auto& engine : engines ) {
+      results.push_back( run( data, workload, deliveries, engine ) );
+      print( results.back() );
+    }
+  }
+
+  return results;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return run_benchmark( argc, argv, "reassembler", program_body );
+}
@@ -0,0 +1,83 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "bitmap: overlapping segments held once", 20, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "bcde", 1 } );
+      test.execute( BytesPending( 4 ) );
+      test.execute( BytesPushed( 0 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 5 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcde" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "bitmap: segments across the ring wraparound", 100, ReassemblerStorage::Bitmap };
+
+      string data;
+      for ( size_t i = 0; i < 500; ++i ) {
+        data += static_cast<char>( 'a' + i % 26 );
+      }
+
+      for ( size_t i = 0; i < data.size(); i += 50 ) {
+        test.execute( Insert { data.substr( i + 25, 25 ), i + 25 } );
+        test.execute( BytesPending( 25 ) );
+        test.execute( Insert { data.substr( i, 25 ), i } );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( data.substr( i, 50 ) ) );
+      }
+      test.execute( BytesPushed( 500 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "bitmap: ring grows with the window", 130, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { string( 128, 'a' ), 0 } );
+      test.execute( Insert { "z", 129 } );
+      test.execute( BytesPending( 1 ) );
+      test.execute( ReadAll( string( 128, 'a' ) ) );
+
+      test.execute( Insert { "y", 200 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( Insert { "x", 128 } );
+      test.execute( BytesPending( 1 ) );
+      test.execute( ReadAll( "xz" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "bitmap: bytes beyond capacity discarded", 4, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { "cdefgh", 2 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcd" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "bitmap: last substring held until the gap fills", 10, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { "c", 2 }.is_last() );
+      test.execute( IsFinished { false } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( ReadAll( "abc" ) );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    for ( const auto storage : { ReassemblerStorage::Map, ReassemblerStorage::Bitmap } ) {
+      {
+        ReassemblerTestHarness test { "buffer: overlapping slices of one payload", 20, storage };
+
+        const Buffer payload { "abcdefgh" };
+        test.execute( InsertBuffer { Buffer { "efgh" }, 4 } );
+        test.execute( InsertBuffer { Buffer { "cdef" }, 2 } );
+        test.execute( BytesPending( 6 ) );
+        test.execute( InsertBuffer { payload, 0 } );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( "abcdefgh" ) );
+        test.execute( InsertBuffer { payload, 0 } );
+        test.execute( BytesPushed( 8 ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "buffer: slice trimmed to capacity", 4, storage };
+
+        test.execute( InsertBuffer { Buffer { "bcdefg" }, 1 } );
+        test.execute( BytesPending( 3 ) );
+        test.execute( Insert { "a", 0 } );
+        test.execute( ReadAll( "abcd" ) );
+        test.execute( InsertBuffer { Buffer { "defgh" }, 3 }.is_last() );
+        test.execute( BytesPending( 0 ) );
+        test.execute( ReadAll( "efgh" ) );
+        test.execute( IsFinished { true } );
+      }
+
+      {
+        ReassemblerTestHarness test { "buffer: held slice outlives the caller's copy", 10, storage };
+
+        {
+          const Buffer payload { "world" };
+          test.execute( InsertBuffer { payload, 5 } );
+        }
+        test.execute( BytesPending( 5 ) );
+        test.execute( InsertBuffer { Buffer { "hello" }, 0 } );
+        test.execute( ReadAll( "helloworld" ) );
+      }
+
+      {
+        ReassemblerTestHarness test { "buffer: small piece of a large payload is held as a copy", 10, storage };
+
+        // only 5 of the 100 bytes fit, so holding them must not keep (or see changes to) the rest
+        Buffer payload { string( 100, 'x' ) };
+        test.execute( InsertBuffer { payload, 5 } );
+        test.execute( BytesPending( 5 ) );
+        static_cast<string&>( payload ).assign( 100, 'y' );
+        test.execute( InsertBuffer { Buffer { "hello" }, 0 } );
+        test.execute( ReadAll( "helloxxxxx" ) );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+void expect_equal( uint64_t actual, uint64_t expected, const string& what )
+{
+  if ( actual != expected ) {
+    throw runtime_error( "ReassemblerPool: expected " + what + " to be " + to_string( expected ) + ", got "
+                         + to_string( actual ) );
+  }
+}
+
+constexpr uint64_t block = 64;                  // smallest block the pool allows
+constexpr uint64_t unit = block + block / 8;    // bytes of pool memory per block: data plus presence bits
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ReassemblerPool pool { 100 * unit, EvictionPolicy::FurthestAhead, block };
+      ReassemblerTestHarness test { "pooled: segments across block boundaries", 1000, pool };
+
+      const string data = [] {
+        string ret;
+        for ( size_t i = 0; i < 300; ++i ) {
+          ret += static_cast<char>( 'a' + i % 26 );
+        }
+        return ret;
+      }();
+
+      test.execute( Insert { data.substr( 200, 100 ), 200 }.is_last() );
+      test.execute( Insert { data.substr( 50, 100 ), 50 } );
+      test.execute( Insert { data.substr( 100, 120 ), 100 } );
+      test.execute( BytesPending( 250 ) );
+      expect_equal( pool.stats().pending_bytes, 250, "pending bytes" );
+      expect_equal( pool.stats().memory_in_use, 5 * unit, "memory in use" );
+
+      test.execute( Insert { data.substr( 0, 60 ), 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( data ) );
+      test.execute( IsFinished { true } );
+      expect_equal( pool.stats().memory_in_use, 0, "memory in use once reassembled" );
+    }
+
+    {
+      ReassemblerPool pool { 2 * unit, EvictionPolicy::FurthestAhead, block };
+      ReassemblerTestHarness near { "pooled: furthest-ahead block evicted first", 1000, pool };
+      ReassemblerTestHarness far { "pooled: furthest-ahead block evicted first (other stream)", 1000, pool };
+
+      near.execute( Insert { "b", 70 } );
+      far.execute( Insert { "z", 330 } );
+      expect_equal( pool.stats().streams, 2, "streams" );
+      expect_equal( pool.stats().memory_in_use, 2 * unit, "memory in use" );
+
+      // the budget is full: the far stream's block is further ahead than the new one, so it goes
+      near.execute( Insert { "c", 130 } );
+      near.execute( BytesPending( 2 ) );
+      far.execute( BytesPending( 0 ) );
+      expect_equal( pool.stats().evicted_bytes, 1, "evicted bytes" );
+
+      // and a block further ahead than anything held is the one dropped
+      far.execute( Insert { "y", 400 } );
+      far.execute( BytesPending( 0 ) );
+      near.execute( BytesPending( 2 ) );
+
+      const auto streams = pool.stream_stats();
+      expect_equal( streams.size(), 2, "stream stats entries" );
+      expect_equal( streams.at( 0 ).pending_bytes + streams.at( 1 ).pending_bytes, 2, "per-stream pending bytes" );
+      expect_equal( streams.at( 0 ).evicted_bytes + streams.at( 1 ).evicted_bytes, 1, "per-stream evicted bytes" );
+    }
+
+    {
+      ReassemblerPool pool { 2 * unit, EvictionPolicy::LargestStream, block };
+      ReassemblerTestHarness large { "pooled: largest stream evicted first", 1000, pool };
+      ReassemblerTestHarness small { "pooled: largest stream evicted first (other stream)", 1000, pool };
+
+      large.execute( Insert { "a", 10 } );
+      large.execute( Insert { "b", 500 } );
+      small.execute( Insert { "c", 900 } );
+      large.execute( BytesPending( 1 ) );
+      small.execute( BytesPending( 1 ) );
+
+      expect_equal( pool.stream_stats().at( 0 ).evicted_bytes, 1, "evicted bytes of the larger stream" );
+      expect_equal( pool.stream_stats().at( 1 ).evicted_bytes, 0, "evicted bytes of the smaller stream" );
+    }
+
+    {
+      ReassemblerPool pool { 0, EvictionPolicy::FurthestAhead, block };
+      ReassemblerTestHarness test { "pooled: no budget still delivers in-order bytes", 10, pool };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( ReadAll( "ab" ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Check held_ranges() against the ranges computed byte by byte from what was inserted
+void random_ranges( Reassembler reassembler, const string& label )
+{
+  default_random_engine rd { 2018 };
+  const uint64_t capacity = 3000;
+  ByteStream stream { capacity };
+  vector<bool> held( capacity );
+
+  for ( int round = 0; round < 2000; ++round ) {
+    const uint64_t start = 1 + rd() % ( capacity - 1 );
+    const uint64_t len = 1 + rd() % min<uint64_t>( 40, capacity - start );
+    reassembler.insert( start, string( len, 'x' ), false, stream.writer() );
+    fill( held.begin() + static_cast<int64_t>( start ), held.begin() + static_cast<int64_t>( start + len ), true );
+
+    vector<ByteRange> expected;
+    const uint64_t max_ranges = rd() % 6;
+    for ( uint64_t i = capacity; i > 0 and expected.size() < max_ranges; ) {
+      if ( not held[i - 1] ) {
+        --i;
+        continue;
+      }
+      const uint64_t end = i;
+      while ( i > 0 and held[i - 1] ) {
+        --i;
+      }
+      expected.push_back( { i, end } );
+    }
+
+    if ( reassembler.held_ranges( max_ranges ) != expected ) {
+      throw runtime_error( "held_ranges (" + label + ") after " + to_string( round + 1 )
+                           + " inserts: expected " + HeldRanges::str( expected ) + ", but found "
+                           + HeldRanges::str( reassembler.held_ranges( max_ranges ) ) );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    ReassemblerPool pool { 1 << 20, EvictionPolicy::FurthestAhead, 64 };
+    for ( const auto storage : { ReassemblerStorage::Map, ReassemblerStorage::Bitmap } ) {
+      ReassemblerTestHarness test { "held ranges: touching segments merge", 100, storage };
+
+      test.execute( HeldRanges( 4, {} ) );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( Insert { "ef", 4 } );
+      test.execute( Insert { "xy", 70 } );
+      test.execute( Insert { "m", 12 } );
+      test.execute( HeldRanges( 4, { { 70, 72 }, { 12, 13 }, { 4, 8 } } ) );
+      test.execute( HeldRanges( 2, { { 70, 72 }, { 12, 13 } } ) );
+      test.execute( HeldRanges( 0, {} ) );
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( HeldRanges( 4, { { 70, 72 }, { 12, 13 } } ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "held ranges: pooled, across block boundaries", 1000, pool };
+
+      test.execute( Insert { string( 100, 'x' ), 50 } );
+      test.execute( Insert { string( 10, 'y' ), 300 } );
+      test.execute( HeldRanges( 4, { { 300, 310 }, { 50, 150 } } ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "held ranges: bitmap window wrapped around", 100, ReassemblerStorage::Bitmap };
+
+      test.execute( Insert { string( 90, 'a' ), 0 } );
+      test.execute( ReadAll( string( 90, 'a' ) ) );
+      test.execute( Insert { "bb", 95 } );
+      test.execute( Insert { "cc", 150 } );
+      test.execute( Insert { "dd", 185 } );
+      test.execute( HeldRanges( 4, { { 185, 187 }, { 150, 152 }, { 95, 97 } } ) );
+    }
+
+    random_ranges( Reassembler {}, "map" );
+    random_ranges( Reassembler { ReassemblerStorage::Bitmap }, "bitmap" );
+    random_ranges( Reassembler { pool }, "pooled" );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -9,13 +9,17 @@
 #include <queue>
 #include <random>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t piece_size = 0,
+                 const ReassemblerStorage storage = ReassemblerStorage::Map,
+                 const size_t batch_size = 0 )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -30,19 +34,60 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
 
   // Split the data into segments before writing
   queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
-    split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
-    split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+  if ( piece_size == 0 ) {
+    for ( size_t i = 0; i < data.size(); i += capacity ) {
+      split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
+      split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
+      split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+    }
+  } else {
+    // Heavily reordered: cut each window of `capacity` bytes into small pieces and deliver them
+    // shuffled, so most of every window sits in the Reassembler before its first byte arrives
+    default_random_engine rd { random_seed };
+    vector<uint64_t> starts;
+    for ( size_t window = 0; window < data.size(); window += capacity ) {
+      starts.clear();
+      for ( size_t i = window; i < min( window + capacity, data.size() ); i += piece_size ) {
+        starts.push_back( i );
+      }
+      shuffle( starts.begin(), starts.end(), rd );
+      for ( const auto i : starts ) {
+        const size_t len = min( piece_size, min( window + capacity, data.size() ) - i );
+        split_data.emplace( i, data.substr( i, len ), i + len == data.size() );
+      }
+    }
   }
 
   ByteStream stream { capacity };
-  Reassembler reassembler;
+  Reassembler reassembler { storage };
 
   string output_data;
   output_data.reserve( data.size() );
 
+  // the batches are built before the clock starts, as if they came from the network that way
+  vector<vector<Reassembler::Segment>> batches;
+  while ( batch_size and not split_data.empty() ) {
+    auto& batch = batches.emplace_back();
+    // a batch ends at a window boundary, since the next window only fits once this one is read
+    while ( not split_data.empty() and batch.size() < batch_size
+            and ( batch.empty()
+                  or get<uint64_t>( split_data.front() ) / capacity == batch.front().first_index / capacity ) ) {
+      auto& next = split_data.front();
+      batch.push_back( { get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ) } );
+      split_data.pop();
+    }
+  }
+
   const auto start_time = steady_clock::now();
+  for ( auto& batch : batches ) {
+    reassembler.insert_batch( batch, stream.writer() );
+
+    while ( stream.reader().bytes_buffered() ) {
+      output_data += stream.reader().peek();
+      stream.reader().pop( output_data.size() - stream.reader().bytes_popped() );
+    }
+  }
+
   while ( not split_data.empty() ) {
     auto& next = split_data.front();
     reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ), stream.writer() );
@@ -72,10 +117,18 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  string label = piece_size ? " (reordered " + to_string( piece_size ) + "-byte pieces)" : "";
+  if ( storage == ReassemblerStorage::Bitmap ) {
+    label += " (bitmap)";
+  }
+  if ( batch_size ) {
+    label += " (batches of " + to_string( batch_size ) + ")";
+  }
+
+  cout << "Reassembler to ByteStream with capacity=" << capacity << label << " reached " << fixed
+       << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+  debug_output << "             Reassembler throughput" << label << ": " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
@@ -86,6 +139,11 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
 void program_body()
 {
   speed_test( 10000, 1500, 1370 );
+  speed_test( 1000, 15000, 1370, 64 );
+  speed_test( 10000, 1500, 1370, 0, ReassemblerStorage::Bitmap );
+  speed_test( 1000, 15000, 1370, 64, ReassemblerStorage::Bitmap );
+  speed_test( 1000, 15000, 1370, 64, ReassemblerStorage::Map, 32 );
+  speed_test( 1000, 15000, 1370, 64, ReassemblerStorage::Bitmap, 32 );
 }
 
 int main()
@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using StreamAndReassembler = std::pair<ByteStream, Reassembler>;
 
@@ -28,10 +29,19 @@ struct ReassemblerByteStreamTestStep : public TestStep<StreamAndReassembler>
 class ReassemblerTestHarness : public TestHarness<StreamAndReassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          ReassemblerStorage storage = ReassemblerStorage::Map )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { ByteStream { capacity }, Reassembler {} } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == ReassemblerStorage::Bitmap ? ", bitmap" : "" ),
+                   { ByteStream { capacity }, Reassembler { storage } } )
+  {}
+
+  ReassemblerTestHarness( std::string test_name, uint64_t capacity, ReassemblerPool& pool )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", pooled",
+                   { ByteStream { capacity }, Reassembler { pool } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -50,6 +60,40 @@ struct BytesPending : public ExpectNumber<StreamAndReassembler, uint64_t>
   uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_pending(); }
 };
 
+struct HeldRanges : public Expectation<StreamAndReassembler>
+{
+  uint64_t max_ranges_;
+  std::vector<ByteRange> ranges_;
+
+  HeldRanges( uint64_t max_ranges, std::vector<ByteRange> ranges )
+    : max_ranges_( max_ranges ), ranges_( std::move( ranges ) )
+  {}
+
+  static std::string str( const std::vector<ByteRange>& ranges )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& range : ranges ) {
+      ss << " [" << range.begin << ", " << range.end << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override
+  {
+    return "held_ranges( " + std::to_string( max_ranges_ ) + " ) = " + str( ranges_ );
+  }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    const auto actual = sr.second.held_ranges( max_ranges_ );
+    if ( actual != ranges_ ) {
+      throw ExpectationViolation { "Expected held ranges " + str( ranges_ ) + ", but found " + str( actual ) };
+    }
+  }
+};
+
 struct Insert : public Action<StreamAndReassembler>
 {
   std::string data_;
@@ -79,3 +123,50 @@ struct Insert : public Action<StreamAndReassembler>
     sr.second.insert( first_index_, data_, is_last_substring_, sr.first.writer() );
   }
 };
+
+// Insert through the Buffer overload: the Reassembler shares `buffer_` instead of copying it
+struct InsertBuffer : public Insert
+{
+  Buffer buffer_;
+
+  InsertBuffer( const Buffer& buffer, uint64_t first_index )
+    : Insert( std::string { std::string_view( buffer ) }, first_index ), buffer_( buffer )
+  {}
+
+  InsertBuffer& is_last( bool status = true )
+  {
+    is_last_substring_ = status;
+    return *this;
+  }
+
+  std::string description() const override { return Insert::description() + " [buffer]"; }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    sr.second.insert( first_index_, buffer_, is_last_substring_, sr.first.writer() );
+  }
+};
+
+struct InsertBatch : public Action<StreamAndReassembler>
+{
+  std::vector<Reassembler::Segment> segments_;
+
+  explicit InsertBatch( std::vector<Reassembler::Segment> segments ) : segments_( std::move( segments ) ) {}
+
+  std::string description() const override
+  {
+    std::ostringstream ss;
+    ss << "insert batch of " << segments_.size() << ":";
+    for ( const auto& segment : segments_ ) {
+      ss << " \"" << Printer::prettify( segment.data ) << "\" @ " << segment.first_index
+         << ( segment.is_last_substring ? " [last]" : "" );
+    }
+    return ss.str();
+  }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    auto segments = segments_;
+    sr.second.insert_batch( segments, sr.first.writer() );
+  }
+};
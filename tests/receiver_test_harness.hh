@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using ReceiverSet = std::pair<StreamAndReassembler, TCPReceiver>;
 
@@ -66,6 +67,44 @@ struct ExpectAckno : public ExpectNumber<ReceiverSet, std::optional<Wrap32>>
   }
 };
 
+struct ExpectSack : public Expectation<ReceiverSet>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+
+  explicit ExpectSack( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string str( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& [left, right] : blocks ) {
+      ss << " [" << left << ", " << right << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override { return "SACK blocks = " + str( blocks_ ); }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    const auto actual = rs.second.send( rs.first.second, rs.first.first.writer() ).sack;
+    if ( actual != blocks_ ) {
+      throw ExpectationViolation { "Expected SACK blocks " + str( blocks_ ) + ", but found " + str( actual ) };
+    }
+  }
+};
+
+struct ExpectTimestampEcho : public ExpectNumber<ReceiverSet, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "timestamp_echo"; }
+  std::optional<uint32_t> value( ReceiverSet& rs ) const override
+  {
+    return rs.second.send( rs.first.first.writer() ).timestamp_echo;
+  }
+};
+
 struct ExpectAcknoBetween : public Expectation<ReceiverSet>
 {
   Wrap32 isn_;
@@ -135,6 +174,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_timestamp( uint32_t timestamp )
+  {
+    msg_.timestamp = timestamp;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -161,6 +206,9 @@ struct SegmentArrives : public Action<ReceiverSet>
     if ( msg_.FIN ) {
       ss << " +FIN";
     }
+    if ( msg_.timestamp.has_value() ) {
+      ss << " TSval=" << msg_.timestamp.value();
+    }
     ss << ")";
 
     if ( ackno_expected_.value_ ) {
@@ -0,0 +1,52 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks for held segments", 4000 };
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 11 ).with_data( "klmn" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 21 ).with_data( "uv" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 21 }, Wrap32 { isn + 23 } },
+                                   { Wrap32 { isn + 11 }, Wrap32 { isn + 15 } } } } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcdefghij" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 15 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 21 }, Wrap32 { isn + 23 } } } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks capped at the highest four", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 1; i <= 6; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 10 * i ).with_data( "x" ) );
+      }
+      test.execute( ExpectSack { { { Wrap32 { isn + 61 }, Wrap32 { isn + 62 } },
+                                   { Wrap32 { isn + 51 }, Wrap32 { isn + 52 } },
+                                   { Wrap32 { isn + 41 }, Wrap32 { isn + 42 } },
+                                   { Wrap32 { isn + 31 }, Wrap32 { isn + 32 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
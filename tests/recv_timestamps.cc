@@ -0,0 +1,47 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "Timestamps of in-order segments are echoed", 4000 };
+      test.execute( ExpectTimestampEcho { nullopt } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 5 ) );
+      test.execute( ExpectTimestampEcho { 5 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 9 ) );
+      test.execute( ExpectTimestampEcho { 9 } );
+
+      // out of order: the echo stays with the segment before the hole
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "j" ).with_timestamp( 12 ) );
+      test.execute( ExpectTimestampEcho { 9 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "defghi" ).with_timestamp( 15 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 11 } } );
+      test.execute( ExpectTimestampEcho { 15 } );
+
+      // a retransmission of bytes already received still updates it
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( 20 ) );
+      test.execute( ExpectTimestampEcho { 20 } );
+
+      // and a segment without a timestamp leaves it alone
+      test.execute( SegmentArrives {}.with_seqno( isn + 11 ).with_data( "k" ) );
+      test.execute( ExpectTimestampEcho { 20 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
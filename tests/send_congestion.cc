@@ -0,0 +1,122 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      cfg.fixed_isn = Wrap32( rd() );
+
+      TCPSenderTestHarness test { "No congestion control leaves the window to the receiver", cfg };
+      test.execute( ExpectCongestionWindow { UINT64_MAX } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectCongestionWindow { UINT64_MAX } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControl::NewReno;
+
+      TCPSenderTestHarness test { "NewReno starts with ten segments and slow-starts", cfg };
+      test.execute( ExpectCongestionWindow { 10 * mss } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 10 * mss + 1 } );
+
+      // the receiver would take it all, but the congestion window holds the rest back, in whole segments
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 10 * mss } );
+
+      // acking two segments opens the window by one segment, so three more go out
+      test.execute( AckReceived { isn + 1 + 2 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 11 * mss + 1 } );
+      for ( uint64_t i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + ( 10 + i ) * mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 11 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 100;
+      cfg.congestion_control = CongestionControl::NewReno;
+
+      TCPSenderTestHarness test { "NewReno falls back to one segment on a timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      test.execute( Tick { 100 } );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+
+      // ssthresh is half of what was in flight, so the window slow-starts up to two segments...
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+
+      // ...and then grows by a segment once a whole window has been acked
+      test.execute( AckReceived { isn + 1 + 2 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( AckReceived { isn + 1 + 3 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( AckReceived { isn + 1 + 4 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    for ( const auto algorithm : { CongestionControl::Cubic, CongestionControl::BbrLite } ) {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 100;
+      cfg.congestion_control = algorithm;
+
+      TCPSenderTestHarness test { "CUBIC and BBR-lite back off on a timeout", cfg };
+      test.execute( ExpectCongestionWindow { 10 * mss } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 30 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 10; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
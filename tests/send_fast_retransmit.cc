@@ -0,0 +1,222 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Three duplicate acks retransmit the missing segment", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+      }
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + mss ) );
+      test.execute( ExpectNoSegment {} );
+
+      // more duplicates don't retransmit it again, and the ack of everything ends the recovery
+      test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1 + 4 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 100;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "A fast retransmission acked before it is sent is dropped", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      }
+      test.execute( AckReceived { isn + 1 + 4 * mss }.with_win( UINT16_MAX ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 100;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "A timeout while a fast retransmission is queued sends it once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      }
+      test.execute( Tick { 100 } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Window updates are not duplicate acks", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 4 * mss ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      for ( uint64_t i = 1; i <= 4; ++i ) {
+        test.execute( AckReceived { isn + 1 }.with_win( 4 * mss - i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without fast retransmit, only the timer retransmits", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      for ( uint64_t i = 0; i < 5; ++i ) {
+        test.execute( AckReceived { isn + 1 + mss }.with_win( UINT16_MAX ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + mss ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.fast_retransmit = true;
+
+      // segments 0 to 6 sent, and 1 and 3 lost
+      TCPSenderTestHarness test { "SACK retransmits exactly the missing segments", cfg };
+      const auto seg = [&]( uint64_t i ) { return isn + 1 + i * mss; };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 7 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 7; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( i ) ) );
+      }
+      test.execute( AckReceived { seg( 1 ) }.with_win( UINT16_MAX ) );
+      test.execute( AckReceived { seg( 1 ) }.with_win( UINT16_MAX ).with_sack( seg( 2 ), seg( 3 ) ) );
+      test.execute(
+        AckReceived { seg( 1 ) }.with_win( UINT16_MAX ).with_sack( seg( 2 ), seg( 3 ) ).with_sack( seg( 4 ), seg( 5 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // three segments above 1 have arrived, but only two above 3
+      test.execute(
+        AckReceived { seg( 1 ) }.with_win( UINT16_MAX ).with_sack( seg( 2 ), seg( 3 ) ).with_sack( seg( 4 ), seg( 6 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( 1 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 6 * mss } );
+
+      test.execute(
+        AckReceived { seg( 1 ) }.with_win( UINT16_MAX ).with_sack( seg( 2 ), seg( 3 ) ).with_sack( seg( 4 ), seg( 7 ) ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+
+      // segment 1's retransmission fills the first hole; 3 has already been retransmitted
+      test.execute( AckReceived { seg( 3 ) }.with_win( UINT16_MAX ).with_sack( seg( 4 ), seg( 7 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { seg( 7 ) }.with_win( UINT16_MAX ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.fast_retransmit = true;
+      cfg.congestion_control = CongestionControl::NewReno;
+
+      // segments 0 to 6 sent, and 1 and 3 lost, with a receiver that doesn't SACK
+      TCPSenderTestHarness test { "NewReno halves its window and repairs each hole on a partial ack", cfg };
+      const auto seg = [&]( uint64_t i ) { return isn + 1 + i * mss; };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( UINT16_MAX ) );
+      test.execute( Push { string( 7 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 7; ++i ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( i ) ) );
+      }
+      test.execute( AckReceived { seg( 1 ) }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 11 * mss + 1 } );
+      for ( uint64_t i = 0; i < 3; ++i ) {
+        test.execute( AckReceived { seg( 1 ) }.with_win( UINT16_MAX ) );
+      }
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( 1 ) ) );
+      test.execute( AckReceived { seg( 1 ) }.with_win( UINT16_MAX ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the retransmission arrives, and the ack stops at the next hole
+      test.execute( AckReceived { seg( 3 ) }.with_win( UINT16_MAX ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( seg( 3 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+
+      test.execute( AckReceived { seg( 7 ) }.with_win( UINT16_MAX ) );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
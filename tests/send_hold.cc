@@ -0,0 +1,110 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Sent bytes stay in the stream until acked", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abcdef" } );
+      test.execute( ExpectMessage {}.with_data( "abcdef" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectStreamBuffered { 6 } );
+      test.execute( Push { "gh" } );
+      test.execute( ExpectMessage {}.with_data( "gh" ).with_seqno( isn + 7 ) );
+      test.execute( ExpectStreamBuffered { 8 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectStreamBuffered { 2 } );
+      test.execute( ExpectSeqnosInFlight { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 9 } } );
+      test.execute( ExpectStreamBuffered { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 100;
+
+      TCPSenderTestHarness test { "Retransmission reuses the held bytes", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4 ) );
+      test.execute( Push { "abcdefgh" } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectStreamBuffered { 8 } );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 3 } }.with_win( 4 ) );
+      test.execute( ExpectMessage {}.with_data( "ef" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectStreamBuffered { 8 } ); // "abcd" is only partly acked
+      test.execute( AckReceived { Wrap32 { isn + 7 } }.with_win( 4 ) );
+      test.execute( ExpectMessage {}.with_data( "gh" ).with_seqno( isn + 7 ) );
+      test.execute( ExpectStreamBuffered { 2 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.send_capacity = 4;
+
+      TCPSenderTestHarness test { "Unacked bytes take up the stream's capacity", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "d" ).with_seqno( isn + 4 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } } );
+      test.execute( Push { "efg" }.with_close() );
+      test.execute( ExpectMessage {}.with_data( "efg" ).with_seqno( isn + 5 ).with_fin( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 9 } } );
+      test.execute( ExpectStreamBuffered { 0 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "The final ack releases the bytes without another push", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.without_push() );
+      test.execute( Push { "abcd" }.with_close() );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ).with_fin( true ) );
+      test.execute( ExpectStreamBuffered { 4 } );
+      test.execute( ExpectStreamFinished { false } );
+      test.execute( AckReceived { Wrap32 { isn + 6 } }.without_push() );
+      test.execute( ExpectStreamBuffered { 0 } );
+      test.execute( ExpectStreamFinished { true } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
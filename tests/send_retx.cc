@@ -112,6 +112,27 @@ int main()
       test.execute( Tick { 1 }.with_max_retx_exceeded( true ) );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Retx queued, then acked before it is sent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectMessage {}.with_payload_size( 4 ).with_seqno( isn + 1 ) );
+      test.execute( Tick { retx_timeout } );
+      test.execute( AckReceived { Wrap32 { isn + 5 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 4ULL * retx_timeout } );
+      test.execute( ExpectNoSegment {} );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,168 @@
+#include "random.hh"
+#include "rtt_estimator.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "A fixed RTO still keeps the estimates", cfg };
+      test.execute( ExpectSmoothedRTT { nullopt } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_timestamp( nullopt ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSmoothedRTT { 50 } );
+      test.execute( ExpectRTTVariation { 25 } );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 999 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 2000 } );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectSmoothedRTT { 50 } ); // the ack can't tell which transmission it answers
+      test.execute( ExpectRTO { 1000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.rto_mode = RTOMode::Karn;
+
+      TCPSenderTestHarness test { "RFC 6298 estimation with Karn's algorithm", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( Tick { 300 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSmoothedRTT { 300 } );
+      test.execute( ExpectRTTVariation { 150 } );
+      test.execute( ExpectRTO { 900 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 899 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( ExpectRTO { 1800 } );
+
+      // an ack of a retransmitted segment gives no sample, so the backed-off RTO stays
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectSmoothedRTT { 300 } );
+      test.execute( ExpectRTO { 1800 } );
+
+      test.execute( Push { "d" } );
+      test.execute( ExpectMessage {}.with_data( "d" ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 5 } );
+      test.execute( ExpectSmoothedRTT { 275 } );
+      test.execute( ExpectRTTVariation { 162.5 } );
+      test.execute( ExpectRTO { 925 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.rto_mode = RTOMode::Karn;
+
+      TCPSenderTestHarness test { "The RTO is clamped, backoff included", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 1 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectRTO { RTTEstimator::MIN_RTO_MS } );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+
+      uint64_t rto = RTTEstimator::MIN_RTO_MS;
+      for ( int i = 0; i < 12; ++i ) {
+        test.execute( Tick { rto - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_data( "a" ) );
+        rto = min( 2 * rto, RTTEstimator::MAX_RTO_MS );
+        test.execute( ExpectRTO { rto } );
+      }
+      test.execute( ExpectRTO { RTTEstimator::MAX_RTO_MS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 65000;
+      cfg.rto_mode = RTOMode::Karn;
+
+      TCPSenderTestHarness test { "A long round trip is clamped to the maximum RTO", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 50000 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSmoothedRTT { 50000 } );
+      test.execute( ExpectRTO { RTTEstimator::MAX_RTO_MS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.rto_mode = RTOMode::Timestamps;
+
+      TCPSenderTestHarness test { "Echoed timestamps time retransmissions too", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_timestamp( 0 ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 }.with_timestamp_echo( 0 ) );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTO { RTTEstimator::MIN_RTO_MS } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 40 ) );
+      test.execute( Tick { RTTEstimator::MIN_RTO_MS } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 240 ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { isn + 4 }.with_timestamp_echo( 240 ) );
+      test.execute( ExpectSmoothedRTT { 38.75 } );
+      test.execute( ExpectRTTVariation { 17.5 } );
+      test.execute( ExpectRTO { RTTEstimator::MIN_RTO_MS } );
+
+      // without an echo, the sender falls back to Karn's algorithm
+      test.execute( Push { "d" } );
+      test.execute( ExpectMessage {}.with_data( "d" ).with_timestamp( 270 ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { isn + 5 } );
+      test.execute( ExpectSmoothedRTT { 37.65625 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -28,6 +28,9 @@ static std::string to_string( const TCPSenderMessage& msg )
   if ( msg.FIN ) {
     o << " +FIN";
   }
+  if ( msg.timestamp.has_value() ) {
+    o << " TSval=" << msg.timestamp.value();
+  }
   o << ")";
   return o.str();
 }
@@ -54,6 +57,48 @@ struct ExpectSeqnosInFlight : public ExpectNumber<StreamAndSender, uint64_t>
   uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
 };
 
+struct ExpectStreamBuffered : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "outbound stream bytes_buffered"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.first.reader().bytes_buffered(); }
+};
+
+struct ExpectStreamFinished : public ExpectBool<StreamAndSender>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "outbound stream is_finished"; }
+  bool value( StreamAndSender& ss ) const override { return ss.first.reader().is_finished(); }
+};
+
+struct ExpectCongestionWindow : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.congestion_window(); }
+};
+
+struct ExpectRTO : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "retransmission_timeout"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.retransmission_timeout(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<StreamAndSender, std::optional<double>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_estimate().srtt_ms"; }
+  std::optional<double> value( StreamAndSender& ss ) const override { return ss.second.rtt_estimate().srtt_ms(); }
+};
+
+struct ExpectRTTVariation : public ExpectNumber<StreamAndSender, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_estimate().rttvar_ms"; }
+  double value( StreamAndSender& ss ) const override { return ss.second.rtt_estimate().rttvar_ms(); }
+};
+
 struct ExpectNoSegment : public Expectation<StreamAndSender>
 {
   std::string description() const override { return "nothing to send"; }
@@ -154,7 +199,14 @@ struct Receive : public Action<StreamAndSender>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    if ( msg_.timestamp_echo.has_value() ) {
+      desc << ", TSecr=" << msg_.timestamp_echo.value();
+    }
+    for ( const auto& [left, right] : msg_.sack ) {
+      desc << ", SACK=" << left << "-" << right;
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -167,9 +219,21 @@ struct Receive : public Action<StreamAndSender>
     return *this;
   }
 
+  Receive& with_timestamp_echo( uint32_t echo )
+  {
+    msg_.timestamp_echo = echo;
+    return *this;
+  }
+
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.emplace_back( left, right );
+    return *this;
+  }
+
   void execute( StreamAndSender& ss ) const override
   {
-    ss.second.receive( msg_ );
+    ss.second.receive( msg_, ss.first.reader() );
     if ( push_ ) {
       ss.second.push( ss.first.reader() );
     }
@@ -199,6 +263,7 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<std::optional<uint32_t>> timestamp {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -239,6 +304,12 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     return *this;
   }
 
+  ExpectMessage& with_timestamp( std::optional<uint32_t> timestamp_ )
+  {
+    timestamp = timestamp_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -261,6 +332,9 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() ) {
       o << ( fin.value() ? " +FIN" : " (no FIN)" );
     }
+    if ( timestamp.has_value() ) {
+      o << " TSval=" << to_string( timestamp.value() );
+    }
     return o.str();
   }
 
@@ -298,6 +372,9 @@ struct ExpectMessage : public Expectation<StreamAndSender>
       throw ExpectationViolation( "Expecting payload of \"" + Printer::prettify( data.value() )
                                   + "\", but instead it was \"" + Printer::prettify( seg.payload ) + "\"" );
     }
+    if ( timestamp.has_value() and seg.timestamp != timestamp.value() ) {
+      throw ExpectationViolation( "timestamp", timestamp.value(), seg.timestamp );
+    }
   }
 };
 
@@ -307,6 +384,11 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
+                   { ByteStream { config.send_capacity },
+                     TCPSender { config.rt_timeout,
+                                 config.fixed_isn,
+                                 config.congestion_control,
+                                 config.rto_mode,
+                                 config.fast_retransmit } } )
   {}
 };
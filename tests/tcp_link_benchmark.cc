@@ -0,0 +1,317 @@
+#include "benchmark_common.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "reassembler.hh"
+#include "rtt_estimator.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender.hh"
+#include "tcp_sender_message.hh"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const Wrap32 ISN { 1 << 30 };
+constexpr uint64_t RTO_MS = 100;
+constexpr uint64_t HEADER_BYTES = 40; // what each segment costs on the wire beyond its payload
+
+// A path with one bottleneck: segments wait in a drop-tail queue for a link of `bytes_per_ms`, then
+// take `delay_ms` to arrive. Acks come back after `delay_ms` without queueing.
+struct Link
+{
+  uint64_t bytes_per_ms;
+  uint64_t delay_ms;
+  uint64_t queue_limit; // bytes the queue holds before it drops
+};
+
+uint64_t wire_size( const TCPSenderMessage& segment )
+{
+  return HEADER_BYTES + segment.payload.size();
+}
+
+// What one transfer saw
+struct Stats
+{
+  uint64_t elapsed_ms = 0;
+  bool finished = false;
+  uint64_t delivered = 0;
+  uint64_t segments_sent = 0;
+  uint64_t retransmissions = 0; // segments sent that start below the highest sequence number already sent
+  uint64_t drops = 0;
+  uint64_t queue_delay_total = 0;
+  uint64_t queue_delay_max = 0;
+  uint64_t segments_forwarded = 0;
+  std::optional<double> srtt_ms {};
+  uint64_t rto_ms = 0;
+  uint64_t holes = 0; // distinct sequence numbers whose first transmission was dropped
+  uint64_t recovery_total_ms = 0;
+  uint64_t recovery_max_ms = 0;
+
+  double goodput_mbit_per_s() const
+  {
+    return 8 * static_cast<double>( delivered ) / static_cast<double>( elapsed_ms ) / 1000;
+  }
+  double mean_queue_delay_ms() const
+  {
+    return static_cast<double>( queue_delay_total ) / static_cast<double>( max<uint64_t>( 1, segments_forwarded ) );
+  }
+  double mean_recovery_ms() const
+  {
+    return static_cast<double>( recovery_total_ms ) / static_cast<double>( max<uint64_t>( 1, holes ) );
+  }
+};
+
+// Moves `transfer_bytes` from a TCPSender to a TCPReceiver (read as fast as it arrives) over `link`,
+// in 1 ms steps of simulated time, for at most `time_limit_ms`. Besides the queue's drops, the link
+// loses each segment with probability `loss_rate`; the receiver reports SACK blocks if `sack` is set.
+Stats transfer( const Link& link,
+                CongestionControl algorithm,
+                RTOMode rto_mode,
+                uint64_t initial_rto_ms,
+                uint64_t transfer_bytes,
+                uint64_t time_limit_ms,
+                bool fast_retransmit = false,
+                bool sack = false,
+                double loss_rate = 0 )
+{
+  const string chunk( TCPConfig::MAX_PAYLOAD_SIZE * 16, 'x' );
+  minstd_rand rng { 144 };
+  bernoulli_distribution lost { loss_rate };
+
+  ByteStream outbound { 1 << 20 };
+  TCPSender sender { initial_rto_ms, ISN, algorithm, rto_mode, fast_retransmit };
+  ByteStream inbound { TCPConfig::DEFAULT_CAPACITY };
+  Reassembler reassembler;
+  TCPReceiver receiver;
+
+  deque<pair<uint64_t, TCPSenderMessage>> queue;     // with when each segment joined the queue
+  deque<pair<uint64_t, TCPSenderMessage>> forward;   // with when each segment arrives
+  deque<pair<uint64_t, TCPReceiverMessage>> reverse; // with when each ack arrives
+  uint64_t queued_bytes = 0;
+  uint64_t link_budget = 0;
+  uint64_t written = 0;
+  uint64_t highest_sent = 0;
+  map<uint64_t, uint64_t> unrepaired; // absolute seqno of each dropped segment not yet delivered, with when
+  Stats stats;
+
+  uint64_t& now = stats.elapsed_ms;
+  for ( ; not inbound.reader().is_finished() and now < time_limit_ms; ++now ) {
+    while ( not forward.empty() and forward.front().first <= now ) {
+      receiver.receive( move( forward.front().second ), reassembler, inbound.writer() );
+      forward.pop_front();
+      stats.delivered += inbound.reader().bytes_buffered();
+      inbound.reader().pop( inbound.reader().bytes_buffered() );
+      reverse.emplace_back( now + link.delay_ms,
+                            sack ? receiver.send( reassembler, inbound.writer() ) : receiver.send( inbound.writer() ) );
+    }
+
+    // a hole is repaired once the receiver has every byte up to it (the SYN takes seqno 0)
+    while ( not unrepaired.empty() and unrepaired.begin()->first <= inbound.writer().bytes_pushed() ) {
+      const uint64_t took = now - unrepaired.begin()->second;
+      stats.recovery_total_ms += took;
+      stats.recovery_max_ms = max( stats.recovery_max_ms, took );
+      unrepaired.erase( unrepaired.begin() );
+    }
+
+    while ( not reverse.empty() and reverse.front().first <= now ) {
+      sender.receive( reverse.front().second, outbound.reader() );
+      reverse.pop_front();
+    }
+
+    while ( written < transfer_bytes and outbound.writer().available_capacity() >= chunk.size() ) {
+      outbound.writer().push( chunk );
+      written += chunk.size();
+    }
+    if ( written >= transfer_bytes and not outbound.writer().is_closed() ) {
+      outbound.writer().close();
+    }
+
+    sender.push( outbound.reader() );
+    while ( auto segment = sender.maybe_send() ) {
+      stats.segments_sent += 1;
+      const uint64_t seqno = segment->seqno.unwrap( ISN, highest_sent );
+      if ( seqno < highest_sent ) {
+        stats.retransmissions += 1;
+      }
+      highest_sent = max( highest_sent, seqno + segment->sequence_length() );
+
+      if ( queued_bytes + wire_size( *segment ) > link.queue_limit or lost( rng ) ) {
+        stats.drops += 1;
+        if ( not segment->payload.empty() and unrepaired.emplace( seqno, now ).second ) {
+          stats.holes += 1;
+        }
+        continue;
+      }
+      queued_bytes += wire_size( *segment );
+      queue.emplace_back( now, move( *segment ) );
+    }
+
+    // the link sends whole segments; credit doesn't build up while it is idle
+    link_budget = queue.empty() ? 0 : link_budget + link.bytes_per_ms;
+    while ( not queue.empty() and wire_size( queue.front().second ) <= link_budget ) {
+      const uint64_t size = wire_size( queue.front().second );
+      const uint64_t waited = now - queue.front().first;
+      link_budget -= size;
+      queued_bytes -= size;
+      stats.queue_delay_total += waited;
+      stats.queue_delay_max = max( stats.queue_delay_max, waited );
+      stats.segments_forwarded += 1;
+      forward.emplace_back( now + link.delay_ms, move( queue.front().second ) );
+      queue.pop_front();
+    }
+
+    sender.tick( 1 );
+  }
+
+  stats.finished = inbound.reader().is_finished();
+  if ( stats.finished and stats.delivered != transfer_bytes ) {
+    throw runtime_error( "delivered " + to_string( stats.delivered ) + " bytes, expected "
+                         + to_string( transfer_bytes ) );
+  }
+  stats.srtt_ms = sender.rtt_estimate().srtt_ms();
+  stats.rto_ms = sender.retransmission_timeout();
+  return stats;
+}
+
+// How each congestion-control algorithm shares a bottleneck's queue: goodput, how long segments waited
+// in the queue, and how many the queue dropped
+BenchmarkResult bottleneck( CongestionControl algorithm, const string& algorithm_name, const Link& link )
+{
+  constexpr uint64_t transfer_bytes = 8'000'000;
+  const Stats stats = transfer( link, algorithm, RTOMode::Fixed, RTO_MS, transfer_bytes, 600'000 );
+  if ( not stats.finished ) {
+    throw runtime_error( algorithm_name + ": transfer did not finish" );
+  }
+
+  const double ideal_ms = static_cast<double>( transfer_bytes ) / static_cast<double>( link.bytes_per_ms );
+  return { { { "scenario", "bottleneck" },
+             { "config",
+               "cc=" + algorithm_name + ",queue=" + to_string( link.queue_limit / TCPConfig::MAX_PAYLOAD_SIZE ) } },
+           { { "goodput_mbit_per_s", stats.goodput_mbit_per_s() },
+             { "link_utilization", ideal_ms / static_cast<double>( stats.elapsed_ms ) },
+             { "mean_queue_delay_ms", stats.mean_queue_delay_ms() },
+             { "max_queue_delay_ms", static_cast<double>( stats.queue_delay_max ) },
+             { "drops", static_cast<double>( stats.drops ) },
+             { "segments_sent", static_cast<double>( stats.segments_sent ) } } };
+}
+
+// How the retransmission timeout copes with a path, over a minute of a bulk transfer: a fixed one is
+// too long for a short round trip, and too short for a long one
+BenchmarkResult rto( RTOMode rto_mode, const string& mode_name, const Link& link, const string& link_name )
+{
+  const Stats stats
+    = transfer( link, CongestionControl::NewReno, rto_mode, TCPConfig::TIMEOUT_DFLT, UINT32_MAX, 60'000 );
+
+  return { { { "scenario", "rto" },
+             { "config", "rto=" + mode_name + ",path=" + link_name } },
+           { { "goodput_mbit_per_s", stats.goodput_mbit_per_s() },
+             { "retransmissions", static_cast<double>( stats.retransmissions ) },
+             { "drops", static_cast<double>( stats.drops ) },
+             { "srtt_ms", stats.srtt_ms.value_or( 0 ) },
+             { "final_rto_ms", static_cast<double>( stats.rto_ms ) } } };
+}
+
+// How long a bulk transfer over a lossy link takes to repair each loss: from the drop until the
+// receiver has every byte before it again
+BenchmarkResult recovery( bool fast_retransmit, bool sack, const string& recovery_name, double loss_rate )
+{
+  constexpr uint64_t transfer_bytes = 8'000'000;
+  const Link link { 1000, 10, 64 * TCPConfig::MAX_PAYLOAD_SIZE };
+  const Stats stats = transfer( link,
+                                CongestionControl::NewReno,
+                                RTOMode::Karn,
+                                TCPConfig::TIMEOUT_DFLT,
+                                transfer_bytes,
+                                600'000,
+                                fast_retransmit,
+                                sack,
+                                loss_rate );
+  if ( not stats.finished ) {
+    throw runtime_error( recovery_name + ": transfer did not finish" );
+  }
+
+  ostringstream loss_name;
+  loss_name << loss_rate * 100 << "%";
+  return { { { "scenario", "recovery" },
+             { "config", "recovery=" + recovery_name + ",loss=" + loss_name.str() } },
+           { { "goodput_mbit_per_s", stats.goodput_mbit_per_s() },
+             { "holes", static_cast<double>( stats.holes ) },
+             { "mean_recovery_ms", stats.mean_recovery_ms() },
+             { "max_recovery_ms", static_cast<double>( stats.recovery_max_ms ) },
+             { "retransmissions", static_cast<double>( stats.retransmissions ) },
+             { "elapsed_ms", static_cast<double>( stats.elapsed_ms ) } } };
+}
+
+vector<BenchmarkResult> program_body()
+{
+  vector<BenchmarkResult> results;
+
+  // 8 Mbit/s and a 20 ms round trip: a bandwidth-delay product of 20 segments, against a receiver
+  // window of 65 that would overrun either queue
+  const vector<pair<CongestionControl, string>> algorithms {
+    { CongestionControl::None, "none" },
+    { CongestionControl::NewReno, "newreno" },
+    { CongestionControl::Cubic, "cubic" },
+    { CongestionControl::BbrLite, "bbr_lite" },
+  };
+  for ( const uint64_t queue_segments : { 10, 40 } ) {
+    const Link link { 1000, 10, queue_segments * TCPConfig::MAX_PAYLOAD_SIZE };
+    for ( const auto& [algorithm, name] : algorithms ) {
+      results.push_back( bottleneck( algorithm, name, link ) );
+      print( results.back() );
+    }
+  }
+
+  // the default 1 s initial RTO against a 20 ms round trip, and against a 1.2 s one
+  const vector<pair<Link, string>> paths {
+    { { 1000, 10, 10 * TCPConfig::MAX_PAYLOAD_SIZE }, "20ms" },
+    { { 1000, 600, 64 * TCPConfig::MAX_PAYLOAD_SIZE }, "1200ms" },
+  };
+  const vector<pair<RTOMode, string>> modes {
+    { RTOMode::Fixed, "fixed" },
+    { RTOMode::Karn, "karn" },
+    { RTOMode::Timestamps, "timestamps" },
+  };
+  for ( const auto& [link, link_name] : paths ) {
+    for ( const auto& [mode, mode_name] : modes ) {
+      results.push_back( rto( mode, mode_name, link, link_name ) );
+      print( results.back() );
+    }
+  }
+
+  // the 20 ms path with random loss: waiting out the RTO, three duplicate acks, and SACK
+  const vector<tuple<bool, bool, string>> recoveries {
+    { false, false, "timeout" },
+    { true, false, "dupack" },
+    { true, true, "sack" },
+  };
+  for ( const double loss_rate : { 0.005, 0.02 } ) {
+    for ( const auto& [fast_retransmit, sack, recovery_name] : recoveries ) {
+      results.push_back( recovery( fast_retransmit, sack, recovery_name, loss_rate ) );
+      print( results.back() );
+    }
+  }
+
+  return results;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return run_benchmark( argc, argv, "tcp_link", program_body );
+}
@@ -0,0 +1,179 @@
+#include "benchmark_common.hh"
+#include "byte_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const Wrap32 ISN { 1 << 30 };
+constexpr uint64_t RTO_MS = 1000;
+
+// A sender that has sent its SYN and had it acknowledged, with the receiver's window wide open
+void connect( ByteStream& stream, TCPSender& sender )
+{
+  sender.push( stream.reader() );
+  if ( not sender.maybe_send().has_value() ) {
+    throw runtime_error( "sender did not send a SYN" );
+  }
+  sender.receive( { ISN + 1, UINT16_MAX, {} }, stream.reader() );
+}
+
+// The cost of sequence_numbers_in_flight() with `outstanding` one-byte segments unacknowledged
+BenchmarkResult in_flight( uint64_t outstanding )
+{
+  ByteStream stream { outstanding + 1 };
+  TCPSender sender { RTO_MS, ISN };
+  connect( stream, sender );
+  for ( uint64_t i = 0; i < outstanding; ++i ) {
+    stream.writer().push( "x" );
+    sender.push( stream.reader() );
+    if ( not sender.maybe_send().has_value() ) {
+      throw runtime_error( "sender did not send segment " + to_string( i ) );
+    }
+  }
+
+  constexpr uint64_t calls = 1 << 16;
+  uint64_t total = 0;
+  const auto start_time = steady_clock::now();
+  for ( uint64_t i = 0; i < calls; ++i ) {
+    total += sender.sequence_numbers_in_flight();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( total != calls * outstanding ) {
+    throw runtime_error( "sequence_numbers_in_flight() was " + to_string( total / calls ) + ", expected "
+                         + to_string( outstanding ) );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  return { { { "scenario", "sequence_numbers_in_flight" },
+             { "config", "outstanding=" + to_string( outstanding ) } },
+           { { "outstanding_segments", static_cast<double>( outstanding ) },
+             { "ns_per_call", seconds * 1e9 / static_cast<double>( calls ) } } };
+}
+
+// Per-segment cost of sending in rounds of `window` one-byte segments: push them all, send them all,
+// then take one ack per segment, the way a receiver acks a burst that arrives in order.
+BenchmarkResult windowed_throughput( uint64_t window )
+{
+  constexpr uint64_t total_segments = 1 << 18;
+  const uint64_t rounds = max<uint64_t>( 1, total_segments / window );
+
+  ByteStream stream { window };
+  TCPSender sender { RTO_MS, ISN };
+  connect( stream, sender );
+  sender.receive( { ISN + 1, static_cast<uint16_t>( window ), {} }, stream.reader() );
+
+  uint64_t acked = 1; // the SYN
+  const auto start_time = steady_clock::now();
+  for ( uint64_t round = 0; round < rounds; ++round ) {
+    for ( uint64_t i = 0; i < window; ++i ) {
+      stream.writer().push( "x" );
+      sender.push( stream.reader() );
+    }
+    for ( uint64_t i = 0; i < window; ++i ) {
+      if ( not sender.maybe_send().has_value() ) {
+        throw runtime_error( "sender stalled in round " + to_string( round ) );
+      }
+    }
+    for ( uint64_t i = 0; i < window; ++i ) {
+      sender.receive( { Wrap32::wrap( ++acked, ISN ), static_cast<uint16_t>( window ), {} }, stream.reader() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( sender.sequence_numbers_in_flight() != 0 ) {
+    throw runtime_error( "segments still in flight after every round was acked" );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const auto segments = static_cast<double>( rounds * window );
+  return { { { "scenario", "windowed_throughput" },
+             { "config", "window=" + to_string( window ) } },
+           { { "window_segments", static_cast<double>( window ) },
+             { "segments", segments },
+             { "ns_per_segment", seconds * 1e9 / segments } } };
+}
+
+// Throughput of cutting large writes into MAX_PAYLOAD_SIZE segments: each round writes a chunk to the
+// stream, sends every segment it makes, and acks them all at once.
+BenchmarkResult segmentation( StreamStorage storage, const string& storage_name )
+{
+  constexpr uint64_t write_size = 16000;
+  constexpr uint64_t rounds = 4096;
+
+  // the writes are built before the clock starts, as if an application had them ready
+  vector<string> writes( rounds, string( write_size, 'x' ) );
+
+  ByteStream stream { 64000, storage };
+  TCPSender sender { RTO_MS, ISN };
+  connect( stream, sender );
+
+  uint64_t acked = 1; // the SYN
+  uint64_t checksum = 0;
+  const auto start_time = steady_clock::now();
+  for ( auto& write : writes ) {
+    stream.writer().push( move( write ) );
+    sender.push( stream.reader() );
+    while ( auto segment = sender.maybe_send() ) {
+      checksum += static_cast<string_view>( segment->payload ).back();
+      acked += segment->sequence_length();
+    }
+    sender.receive( { Wrap32::wrap( acked, ISN ), UINT16_MAX, {} }, stream.reader() );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( acked != 1 + rounds * write_size or checksum != rounds * write_size / TCPConfig::MAX_PAYLOAD_SIZE * 'x' ) {
+    throw runtime_error( "segmentation: " + to_string( acked - 1 ) + " bytes were sent, expected "
+                         + to_string( rounds * write_size ) );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const auto bytes = static_cast<double>( rounds * write_size );
+  return { { { "scenario", "segmentation" },
+             { "config", "storage=" + storage_name } },
+           { { "gbit_per_s", 8 * bytes / seconds / 1e9 },
+             { "ns_per_segment", seconds * 1e9 / ( bytes / TCPConfig::MAX_PAYLOAD_SIZE ) } } };
+}
+
+vector<BenchmarkResult> program_body()
+{
+  vector<BenchmarkResult> results;
+
+  // the receiver's window (at most 65,535) bounds how many segments can be outstanding
+  for ( const uint64_t outstanding : { 1024, 4096, 16384, 65534 } ) {
+    results.push_back( in_flight( outstanding ) );
+    print( results.back() );
+  }
+
+  for ( const uint64_t window : { 16, 1024, 10000, 65535 } ) {
+    results.push_back( windowed_throughput( window ) );
+    print( results.back() );
+  }
+
+  results.push_back( segmentation( StreamStorage::Ring, "ring" ) );
+  print( results.back() );
+  results.push_back( segmentation( StreamStorage::Chunked, "chunked" ) );
+  print( results.back() );
+
+  return results;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return run_benchmark( argc, argv, "tcp_sender", program_body );
+}
@@ -0,0 +1,81 @@
+#include "conversions.hh"
+#include "random.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+void check_batch( const vector<Wrap32>& seqnos, const Wrap32 isn, const uint64_t checkpoint )
+{
+  vector<uint64_t> out( seqnos.size() + 1, 12345 );
+  Wrap32::unwrap_batch( seqnos, isn, checkpoint, out );
+
+  for ( size_t i = 0; i < seqnos.size(); i++ ) {
+    if ( out[i] != seqnos[i].unwrap( isn, checkpoint ) ) {
+      ostringstream ss;
+      ss << "Expected unwrap_batch() to agree with unwrap(), and it didn't!\n";
+      ss << "  element " << i << " of " << seqnos.size() << " is " << seqnos[i] << ", with isn = " << isn
+         << " and checkpoint = " << checkpoint << "\n";
+      ss << "  unwrap() gave " << seqnos[i].unwrap( isn, checkpoint ) << ", unwrap_batch() gave " << out[i] << "\n";
+      throw runtime_error( ss.str() );
+    }
+  }
+
+  if ( out.back() != 12345 ) {
+    throw runtime_error( "unwrap_batch() wrote past the end of its input" );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    uniform_int_distribution<uint32_t> dist32 { 0, numeric_limits<uint32_t>::max() };
+    uniform_int_distribution<uint64_t> dist63 { 0, uint64_t { 1 } << 63 };
+    uniform_int_distribution<size_t> length { 0, 37 };
+
+    for ( unsigned int i = 0; i < 20000; i++ ) {
+      const Wrap32 isn { dist32( rd ) };
+      vector<Wrap32> seqnos;
+      for ( size_t n = length( rd ); n > 0; n-- ) {
+        seqnos.emplace_back( dist32( rd ) );
+      }
+
+      // checkpoints anywhere, in the first wrap (where going back may go below zero), and at its edges
+      check_batch( seqnos, isn, dist63( rd ) );
+      check_batch( seqnos, isn, dist32( rd ) );
+      check_batch( seqnos, isn, 0 );
+      check_batch( seqnos, isn, numeric_limits<uint32_t>::max() );
+      check_batch( seqnos, isn, uint64_t { 1 } << 32 );
+    }
+
+    // a seqno exactly 2^31 away from the checkpoint is a tie, which goes forward
+    const vector<Wrap32> ties( 8, Wrap32 { 1U << 31 } );
+    vector<uint64_t> out( ties.size() );
+    Wrap32::unwrap_batch( ties, Wrap32 { 0 }, uint64_t { 1 } << 32, out );
+    if ( out.front() != ( uint64_t { 3 } << 31 ) ) {
+      throw runtime_error( "unwrap_batch() broke a tie backwards" );
+    }
+
+    // the output must have room for every result
+    bool threw = false;
+    try {
+      Wrap32::unwrap_batch( ties, Wrap32 { 0 }, 0, span<uint64_t> { out }.first( 7 ) );
+    } catch ( const runtime_error& ) {
+      threw = true;
+    }
+    if ( not threw ) {
+      throw runtime_error( "unwrap_batch() accepted an output shorter than its input" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+#include "benchmark_common.hh"
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// The unwrap this library used to ship: floating-point powers of two and three candidate gaps,
+// compiled out of line as it was when it lived in wrapping_integers.cc.
+uint64_t legacy_gap_to_checkpoint( uint64_t times, uint64_t checkpoint, uint64_t offset )
+{
+  const uint64_t absolute = times * static_cast<uint64_t>( pow( 2, 32 ) ) + offset;
+  if ( absolute > checkpoint ) {
+    return absolute - checkpoint;
+  }
+  return checkpoint - absolute;
+}
+
+[[gnu::noinline]] uint64_t legacy_unwrap( uint32_t raw_value, uint32_t zero_point, uint64_t checkpoint )
+{
+  const uint64_t offset = static_cast<uint32_t>( raw_value - zero_point );
+  const uint64_t times = checkpoint / static_cast<uint64_t>( pow( 2, 32 ) );
+  const uint64_t base = static_cast<uint64_t>( UINT32_MAX ) + 1;
+  uint64_t gap1 = base;
+  if ( times > 0 ) {
+    gap1 = legacy_gap_to_checkpoint( times - 1, checkpoint, offset );
+  }
+  const uint64_t gap2 = legacy_gap_to_checkpoint( times, checkpoint, offset );
+  const uint64_t gap3 = legacy_gap_to_checkpoint( times + 1, checkpoint, offset );
+
+  if ( gap1 < gap2 ) {
+    return gap1 < gap3 ? ( times - 1 ) * base + offset : ( times + 1 ) * base + offset;
+  }
+  return gap2 < gap3 ? times * base + offset : ( times + 1 ) * base + offset;
+}
+
+// The cases below are checked at compile time, which is only possible now that unwrap is constexpr
+static_assert( Wrap32 { 5 }.unwrap( Wrap32 { 0 }, 0 ) == 5 );
+static_assert( Wrap32 { 0 }.unwrap( Wrap32 { 1 }, 0 ) == UINT32_MAX );
+static_assert( Wrap32 { 0 }.unwrap( Wrap32 { 0 }, 3ULL << 32 ) == 3ULL << 32 );
+static_assert( Wrap32 { 1U << 31 }.unwrap( Wrap32 { 0 }, 1ULL << 32 ) == 3ULL << 31 ); // a tie goes forward
+static_assert( Wrap32::wrap( ( 1ULL << 32 ) + 17, Wrap32 { UINT32_MAX } ) == Wrap32 { 16 } );
+
+struct Query
+{
+  uint32_t raw_value;
+  uint32_t zero_point;
+  uint64_t checkpoint;
+};
+
+// A set of queries is a distribution of checkpoints, and of sequence numbers around them
+struct Workload
+{
+  string name;
+  function<Query( default_random_engine& rd )> query;
+};
+
+vector<Workload> workloads()
+{
+  return {
+    { "random",
+      []( default_random_engine& rd ) {
+        // any sequence number against any checkpoint of a stream up to 1 TiB long
+        uniform_int_distribution<uint64_t> checkpoint { 0, 1ULL << 40 };
+        return Query { static_cast<uint32_t>( rd() ), static_cast<uint32_t>( rd() ), checkpoint( rd ) };
+      } },
+    { "in_window",
+      []( default_random_engine& rd ) {
+        // the receiver's case: the segment lands within 64 KiB either side of the checkpoint
+        uniform_int_distribution<uint64_t> checkpoint { 1ULL << 16, 1ULL << 40 };
+        uniform_int_distribution<int64_t> distance { -( 1 << 16 ), 1 << 16 };
+        const auto zero_point = static_cast<uint32_t>( rd() );
+        const uint64_t cp = checkpoint( rd );
+        const uint64_t absolute = cp + distance( rd );
+        return Query { static_cast<uint32_t>( absolute ) + zero_point, zero_point, cp };
+      } },
+    { "first_wrap",
+      []( default_random_engine& rd ) {
+        // checkpoints in the first 4 GiB, where the candidate below the checkpoint may not exist
+        uniform_int_distribution<uint64_t> checkpoint { 0, UINT32_MAX };
+        return Query { static_cast<uint32_t>( rd() ), static_cast<uint32_t>( rd() ), checkpoint( rd ) };
+      } },
+  };
+}
+
+constexpr size_t NUM_QUERIES = 1 << 12; // small enough to stay in L1, so that the arithmetic is what gets timed
+constexpr size_t NUM_PASSES = 4096;
+
+template<typename Unwrap>
+BenchmarkResult run( const string& workload,
+                     const string& implementation,
+                     const vector<Query>& queries,
+                     Unwrap&& unwrap )
+{
+  uint64_t checksum = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t pass = 0; pass < NUM_PASSES; ++pass ) {
+    for ( const auto& query : queries ) {
+      checksum += unwrap( query );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  // keep the work observable so that none of it is optimized away
+  if ( checksum == 1 ) {
+    cerr << "";
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  return { { { "workload", workload }, { "implementation", implementation } },
+           { { "ns_per_unwrap", seconds * 1e9 / static_cast<double>( NUM_PASSES * queries.size() ) } } };
+}
+
+vector<BenchmarkResult> program_body()
+{
+  vector<BenchmarkResult> results;
+  for ( const auto& workload : workloads() ) {
+    default_random_engine rd { 5566 };
+    vector<Query> queries;
+    queries.reserve( NUM_QUERIES );
+    for ( size_t i = 0; i < NUM_QUERIES; ++i ) {
+      queries.push_back( workload.query( rd ) );
+    }
+
+    // both implementations must agree on every query before either one is timed
+    for ( const auto& q : queries ) {
+      const uint64_t expected = legacy_unwrap( q.raw_value, q.zero_point, q.checkpoint );
+      const uint64_t actual = Wrap32 { q.raw_value }.unwrap( Wrap32 { q.zero_point }, q.checkpoint );
+      if ( actual != expected ) {
+        throw runtime_error( workload.name + ": unwrap of " + to_string( q.raw_value ) + " with zero point "
+                             + to_string( q.zero_point ) + " near " + to_string( q.checkpoint ) + " gave "
+                             + to_string( actual ) + ", expected " + to_string( expected ) );
+      }
+    }
+
+    results.push_back( run( workload.name, "legacy", queries, []( const Query& q ) {
+      return legacy_unwrap( q.raw_value, q.zero_point, q.checkpoint );
+    } ) );
+    results.push_back( run( workload.name, "integer", queries, []( const Query& q ) {
+      return Wrap32 { q.raw_value }.unwrap( Wrap32 { q.zero_point }, q.checkpoint );
+    } ) );
+
+    const double legacy = results[results.size() - 2].metric( "ns_per_unwrap" );
+    const double integer = results.back().metric( "ns_per_unwrap" );
+    cerr << "             " << workload.name << ": legacy " << fixed << setprecision( 2 ) << legacy
+         << " ns, integer " << integer << " ns per unwrap (" << legacy / integer << "x)\n";
+  }
+
+  // a batch of seqnos from one connection, all near the same checkpoint, as when working through a trace
+  {
+    default_random_engine rd { 7788 };
+    const Wrap32 zero_point { static_cast<uint32_t>( rd() ) };
+    const uint64_t checkpoint = ( 5ULL << 32 ) + rd();
+    uniform_int_distribution<int64_t> distance { -( 1 << 20 ), 1 << 20 };
+    vector<Wrap32> seqnos;
+    for ( size_t i = 0; i < NUM_QUERIES; ++i ) {
+      seqnos.push_back( Wrap32::wrap( checkpoint + distance( rd ), zero_point ) );
+    }
+    vector<uint64_t> out( seqnos.size() );
+
+    Wrap32::unwrap_batch( seqnos, zero_point, checkpoint, out );
+    for ( size_t i = 0; i < seqnos.size(); ++i ) {
+      if ( out[i] != seqnos[i].unwrap( zero_point, checkpoint ) ) {
+        throw runtime_error( "batch: unwrap_batch disagrees with unwrap at element " + to_string( i ) );
+      }
+    }
+
+    const auto time = [&]( const string& implementation, auto&& body ) {
+      const auto start_time = steady_clock::now();
+      for ( size_t pass = 0; pass < NUM_PASSES; ++pass ) {
+        body();
+        asm volatile( "" : : "r"( out.data() ) : "memory" ); // make every pass's results count
+      }
+      const auto stop_time = steady_clock::now();
+      const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+      const double ns_per_unwrap = seconds * 1e9 / static_cast<double>( NUM_PASSES * seqnos.size() );
+      results.push_back( { { { "workload", "batch" }, { "implementation", implementation } },
+                           { { "ns_per_unwrap", ns_per_unwrap } } } );
+    };
+    time( "scalar_loop", [&] {
+      for ( size_t i = 0; i < seqnos.size(); ++i ) {
+        out[i] = seqnos[i].unwrap( zero_point, checkpoint );
+      }
+    } );
+    time( "unwrap_batch", [&] { Wrap32::unwrap_batch( seqnos, zero_point, checkpoint, out ); } );
+
+    const double scalar = results[results.size() - 2].metric( "ns_per_unwrap" );
+    const double batch = results.back().metric( "ns_per_unwrap" );
+    cerr << "             batch: scalar loop " << fixed << setprecision( 2 ) << scalar << " ns, unwrap_batch "
+         << batch << " ns per unwrap (" << scalar / batch << "x)\n";
+  }
+
+  return results;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  return run_benchmark( argc, argv, "wrapping_integers", program_body );
+}
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 class Buffer
 {
@@ -21,3 +22,28 @@ public:
   size_t length() const { return buffer_->length(); }
   bool empty() const { return buffer_->empty(); }
 };
+
+// A range of bytes inside a Buffer. Holding the slice keeps the whole Buffer alive, so the bytes can
+// be trimmed (by moving the offset and length) and passed around without being copied.
+struct BufferSlice
+{
+  Buffer buffer {};
+  size_t offset {};
+  size_t length {};
+
+  BufferSlice() = default;
+  BufferSlice( Buffer buf, size_t off, size_t len ) : buffer( std::move( buf ) ), offset( off ), length( len ) {}
+
+  // NOLINTBEGIN(*-explicit-*)
+
+  // The whole of a Buffer (or string), so that a slice can stand in wherever a Buffer was used
+  BufferSlice( Buffer buf ) : buffer( std::move( buf ) ), offset( 0 ), length( buffer.size() ) {}
+  BufferSlice( std::string str ) : BufferSlice( Buffer { std::move( str ) } ) {}
+  operator std::string_view() const { return view(); }
+
+  // NOLINTEND(*-explicit-*)
+
+  std::string_view view() const { return std::string_view( buffer ).substr( offset, length ); }
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+};
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,6 +66,11 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::unique_ptr<std::string>>& buffers );
 
+  // Read directly into caller-owned memory (e.g. a span from Writer::reserve)
+  // returns number of bytes read
+  size_t read( std::span<char> buffer );
+  size_t read( const std::vector<std::span<char>>& buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
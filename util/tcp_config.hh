@@ -6,6 +6,9 @@
 #include <cstdint>
 #include <optional>
 
+enum class CongestionControl : uint8_t; // defined in congestion_control.hh
+enum class RTOMode : uint8_t;           // defined in rtt_estimator.hh
+
 //! Config for TCP sender and receiver
 class TCPConfig
 {
@@ -14,9 +17,13 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr unsigned DUP_ACK_THRESHOLD = 3;  //!< Duplicate ACKs (or SACKed segments above) that mean a loss
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   std::optional<Wrap32> fixed_isn {};
+  CongestionControl congestion_control {}; //!< Congestion control the sender runs (CongestionControl::None)
+  RTOMode rto_mode {};                     //!< How the sender adapts its retransmission timeout (RTOMode::Fixed)
+  bool fast_retransmit = false;            //!< Also retransmit on duplicate ACKs and SACKed losses, not just the RTO
 };
@@ -2,12 +2,16 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <utility>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains two fields:
+ * It contains four fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
@@ -15,10 +19,22 @@
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
  *    the <cstdint> header).
+ *
+ * 3) Selective acknowledgments (SACK, RFC 2018): ranges of sequence numbers beyond the ackno that the
+ *    receiver already holds, as [left edge, right edge) pairs, highest first and at most MAX_SACK_BLOCKS
+ *    of them. Empty if the receiver holds nothing out of order, or does not report what it holds.
+ *
+ * 4) The timestamp echo (TSecr, RFC 7323): the timestamp of the latest segment that arrived in order,
+ *    which lets the sender time the round trip even of a retransmitted segment. Empty if no segment
+ *    carried one.
  */
 
 struct TCPReceiverMessage
 {
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
+  std::vector<std::pair<Wrap32, Wrap32>> sack {};
+  std::optional<uint32_t> timestamp_echo {};
+
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP options
 };
@@ -3,12 +3,14 @@
 #include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains four fields:
+ * It contains five fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -16,17 +18,22 @@
  * 2) The SYN flag. If set, it means this segment is the beginning of the byte stream, and that
  *    the seqno field contains the Initial Sequence Number (ISN) -- the zero point.
  *
- * 3) The payload: a substring (possibly empty) of the byte stream.
+ * 3) The payload: a substring (possibly empty) of the byte stream, as a slice of a shared Buffer so that
+ *    the sender can hand out (and retransmit) pieces of its stream without copying them.
  *
  * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * 5) The timestamp (TSval, RFC 7323): the sender's clock in milliseconds when it sent the segment, for the
+ *    receiver to echo back. Empty if the sender doesn't time round trips this way.
  */
 
 struct TCPSenderMessage
 {
   Wrap32 seqno { 0 };
   bool SYN { false };
-  Buffer payload {};
+  BufferSlice payload {};
   bool FIN { false };
+  std::optional<uint32_t> timestamp {};
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }